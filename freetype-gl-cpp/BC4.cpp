@@ -0,0 +1,261 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "BC4.h"
+#include <cstdint>
+#include <cstring>
+#include "Simd.h"
+
+// Palette level (0 = minimum, 7 = maximum) of every pixel of the block,
+// rounded to the nearest level.
+static void bc4_levels_scalar(const unsigned char* p, unsigned lo, unsigned hi,
+                              unsigned char* levels)
+{
+	unsigned range = hi - lo;
+
+	for (int i = 0; i < 16; ++i)
+	{
+		levels[i] = static_cast<unsigned char>(
+			((p[i] - lo) * 14 + range) / (2 * range));
+	}
+}
+
+#if defined(FTGL_SSE2)
+static void bc4_levels_simd(const unsigned char* p, unsigned lo, unsigned hi,
+                            unsigned char* levels)
+{
+	unsigned range = hi - lo;
+
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i zero = _mm_setzero_si128();
+	__m128i min = _mm_set1_epi16(short(lo));
+	__m128i scale = _mm_set1_epi16(14);
+
+	__m128i d0 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpacklo_epi8(v, zero), min), scale);
+	__m128i d1 = _mm_mullo_epi16(_mm_sub_epi16(_mm_unpackhi_epi8(v, zero), min), scale);
+	__m128i l0 = zero;
+	__m128i l1 = zero;
+
+	// Level k is reached once 14 * (p - lo) >= (2k - 1) * range
+	for (unsigned k = 1; k < 8; ++k)
+	{
+		__m128i threshold = _mm_set1_epi16(short((2 * k - 1) * range - 1));
+		l0 = _mm_sub_epi16(l0, _mm_cmpgt_epi16(d0, threshold));
+		l1 = _mm_sub_epi16(l1, _mm_cmpgt_epi16(d1, threshold));
+	}
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(levels), _mm_packus_epi16(l0, l1));
+}
+
+static void bc4_range_simd(const unsigned char* p, unsigned& lo, unsigned& hi)
+{
+	__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	__m128i mn = v;
+	__m128i mx = v;
+	mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 8));
+	mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 8));
+	mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 4));
+	mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 4));
+	mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 2));
+	mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 2));
+	mn = _mm_min_epu8(mn, _mm_srli_si128(mn, 1));
+	mx = _mm_max_epu8(mx, _mm_srli_si128(mx, 1));
+	lo = unsigned(_mm_cvtsi128_si32(mn)) & 0xff;
+	hi = unsigned(_mm_cvtsi128_si32(mx)) & 0xff;
+}
+#elif defined(FTGL_NEON)
+static void bc4_levels_simd(const unsigned char* p, unsigned lo, unsigned hi,
+                            unsigned char* levels)
+{
+	unsigned range = hi - lo;
+
+	uint8x16_t v = vsubq_u8(vld1q_u8(p), vdupq_n_u8(uint8_t(lo)));
+	uint8x8_t scale = vdup_n_u8(14);
+
+	uint16x8_t d0 = vmull_u8(vget_low_u8(v), scale);
+	uint16x8_t d1 = vmull_u8(vget_high_u8(v), scale);
+	uint16x8_t l0 = vdupq_n_u16(0);
+	uint16x8_t l1 = vdupq_n_u16(0);
+
+	// Level k is reached once 14 * (p - lo) >= (2k - 1) * range
+	for (unsigned k = 1; k < 8; ++k)
+	{
+		uint16x8_t threshold = vdupq_n_u16(uint16_t((2 * k - 1) * range));
+		l0 = vsubq_u16(l0, vcgeq_u16(d0, threshold));
+		l1 = vsubq_u16(l1, vcgeq_u16(d1, threshold));
+	}
+	vst1q_u8(levels, vcombine_u8(vmovn_u16(l0), vmovn_u16(l1)));
+}
+
+static void bc4_range_simd(const unsigned char* p, unsigned& lo, unsigned& hi)
+{
+	uint8x16_t v = vld1q_u8(p);
+	uint8x8_t mn = vpmin_u8(vget_low_u8(v), vget_high_u8(v));
+	uint8x8_t mx = vpmax_u8(vget_low_u8(v), vget_high_u8(v));
+	mn = vpmin_u8(mn, mn);
+	mx = vpmax_u8(mx, mx);
+	mn = vpmin_u8(mn, mn);
+	mx = vpmax_u8(mx, mx);
+	mn = vpmin_u8(mn, mn);
+	mx = vpmax_u8(mx, mx);
+	lo = vget_lane_u8(mn, 0);
+	hi = vget_lane_u8(mx, 0);
+}
+#endif
+
+static void bc4_range_scalar(const unsigned char* p, unsigned& lo, unsigned& hi)
+{
+	lo = hi = p[0];
+	for (int i = 1; i < 16; ++i)
+	{
+		if (p[i] < lo) lo = p[i];
+		if (p[i] > hi) hi = p[i];
+	}
+}
+
+static void bc4_load(const unsigned char* pixels, size_t stride,
+                     unsigned char* p)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		memcpy(p + 4 * row, pixels + row * stride, 4);
+	}
+}
+
+// Write the references and the palette indices of the levels
+static void bc4_pack(unsigned lo, unsigned hi, const unsigned char* levels,
+                     unsigned char* block)
+{
+	block[0] = static_cast<unsigned char>(hi);
+	block[1] = static_cast<unsigned char>(lo);
+
+	// Index 0 is the maximum, 1 the minimum, 2..7 go down from the maximum
+	static constexpr unsigned char index[8] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+
+	uint64_t bits = 0;
+	for (int i = 0; i < 16; ++i)
+	{
+		bits |= uint64_t(index[levels[i]]) << (3 * i);
+	}
+	for (int i = 0; i < 6; ++i)
+	{
+		block[2 + i] = static_cast<unsigned char>(bits >> (8 * i));
+	}
+}
+
+// A flat block only needs its references, every index selects the maximum
+static void bc4_pack_flat(unsigned value, unsigned char* block)
+{
+	block[0] = block[1] = static_cast<unsigned char>(value);
+	memset(block + 2, 0, 6);
+}
+
+void ftgl::bc4_encode_block(const unsigned char* pixels, size_t stride,
+                            unsigned char* block)
+{
+#if defined(FTGL_SSE2) || defined(FTGL_NEON)
+	unsigned char p[16];
+	bc4_load(pixels, stride, p);
+
+	unsigned lo, hi;
+	bc4_range_simd(p, lo, hi);
+	if (lo == hi)
+	{
+		bc4_pack_flat(lo, block);
+		return;
+	}
+
+	unsigned char levels[16];
+	bc4_levels_simd(p, lo, hi, levels);
+	bc4_pack(lo, hi, levels, block);
+#else
+	bc4_encode_block_scalar(pixels, stride, block);
+#endif
+}
+
+void ftgl::bc4_encode_block_scalar(const unsigned char* pixels, size_t stride,
+                                   unsigned char* block)
+{
+	unsigned char p[16];
+	bc4_load(pixels, stride, p);
+
+	unsigned lo, hi;
+	bc4_range_scalar(p, lo, hi);
+	if (lo == hi)
+	{
+		bc4_pack_flat(lo, block);
+		return;
+	}
+
+	unsigned char levels[16];
+	bc4_levels_scalar(p, lo, hi, levels);
+	bc4_pack(lo, hi, levels, block);
+}
+
+void ftgl::bc4_decode_block(const unsigned char* block,
+                            unsigned char* pixels, size_t stride)
+{
+	unsigned r0 = block[0];
+	unsigned r1 = block[1];
+	unsigned char palette[8];
+
+	palette[0] = static_cast<unsigned char>(r0);
+	palette[1] = static_cast<unsigned char>(r1);
+	if (r0 > r1)
+	{
+		for (unsigned i = 2; i < 8; ++i)
+		{
+			palette[i] = static_cast<unsigned char>(
+				((8 - i) * r0 + (i - 1) * r1 + 3) / 7);
+		}
+	}
+	else
+	{
+		for (unsigned i = 2; i < 6; ++i)
+		{
+			palette[i] = static_cast<unsigned char>(
+				((6 - i) * r0 + (i - 1) * r1 + 2) / 5);
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+
+	uint64_t bits = 0;
+	for (int i = 0; i < 6; ++i)
+	{
+		bits |= uint64_t(block[2 + i]) << (8 * i);
+	}
+	for (int i = 0; i < 16; ++i)
+	{
+		pixels[(i / 4) * stride + i % 4] = palette[(bits >> (3 * i)) & 7];
+	}
+}
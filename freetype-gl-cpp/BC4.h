@@ -0,0 +1,73 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+
+namespace ftgl {
+
+/*
+ * BC4 (RGTC1) block compression of single channel images.
+ *
+ * A block holds 4x4 pixels in 8 bytes: two reference values followed by
+ * sixteen 3-bit palette indices. The encoder always uses the 8 value mode
+ * (first reference larger than the second) with the block minimum and
+ * maximum as references; the decoder handles both modes.
+ *
+ * bc4_encode_block uses the SIMD kernels of Simd.h when available and
+ * produces the same bytes as bc4_encode_block_scalar, the portable
+ * version it falls back to.
+ */
+
+// --------------------------------------------------------- BC4_BLOCK_SIZE ---
+static constexpr size_t BC4_BLOCK_SIZE = 8;
+
+// ------------------------------------------------------- bc4_encode_block ---
+void
+bc4_encode_block(const unsigned char* pixels, size_t stride,
+                 unsigned char* block)
+;
+
+// ------------------------------------------------ bc4_encode_block_scalar ---
+void
+bc4_encode_block_scalar(const unsigned char* pixels, size_t stride,
+                        unsigned char* block)
+;
+
+// ------------------------------------------------------- bc4_decode_block ---
+void
+bc4_decode_block(const unsigned char* block,
+                 unsigned char* pixels, size_t stride)
+;
+
+}//namespace ftgl
@@ -0,0 +1,228 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "FaceCache.h"
+#include <cassert>
+#include <iterator>
+#include <tuple>
+
+#include <ft2build.h>
+#include FT_FREETYPE_H
+#include FT_SIZES_H
+
+#define FTGL_STDERR_DISPLAY
+
+#ifdef FTGL_STDERR_DISPLAY
+#include "FT_Errors.h"
+#endif
+
+namespace {
+
+// Source of a face: the bytes it is read from, or its path
+struct Key
+{
+	const void* data;
+	std::string path;
+	long index;
+
+	bool operator<(const Key& other) const
+	{
+		return std::tie(data, path, index)
+			< std::tie(other.data, other.path, other.index);
+	}
+};
+
+// Faces currently open
+std::mutex registry_mutex;
+std::map<Key, std::weak_ptr<ftgl::FaceCache::Entry>> registry;
+
+void report(FT_Error error, int line)
+{
+#ifdef FTGL_STDERR_DISPLAY
+	fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
+		line, FT_Errors[error].code, FT_Errors[error].message);
+#endif
+}
+
+// Open the face of a source with create, or share the one already open
+template<typename Create>
+std::shared_ptr<ftgl::FaceCache::Entry> lookup(const Key& key, Create create)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	auto it = registry.find(key);
+	if (it != registry.end())
+	{
+		if (auto entry = it->second.lock())
+		{
+			return entry;
+		}
+	}
+
+	// Drop the faces released since, their weak pointers hold the memory
+	// of the entries
+	for (it = registry.begin(); it != registry.end();)
+	{
+		it = it->second.expired() ? registry.erase(it) : std::next(it);
+	}
+
+	auto entry = std::make_shared<ftgl::FaceCache::Entry>();
+	FT_Error error = FT_Init_FreeType(&entry->library);
+	if (error)
+	{
+		report(error, __LINE__);
+		entry->library = nullptr;
+		return nullptr;
+	}
+
+	error = create(entry->library, &entry->face);
+	if (error)
+	{
+		report(error, __LINE__);
+		entry->face = nullptr;
+		return nullptr;
+	}
+
+	error = FT_Select_Charmap(entry->face, FT_ENCODING_UNICODE);
+	if (error)
+	{
+		report(error, __LINE__);
+		return nullptr;
+	}
+
+	// Only faces that opened are shared
+	registry.emplace(key, entry);
+	return entry;
+}
+
+}// namespace
+
+ftgl::FaceCache::Entry::~Entry()
+{
+	// Sizes are released with their face
+	if (face)
+	{
+		FT_Done_Face(face);
+	}
+	if (library)
+	{
+		FT_Done_FreeType(library);
+	}
+}
+
+std::shared_ptr<ftgl::FaceCache::Entry>
+ftgl::FaceCache::open(std::shared_ptr<FontFile> file, long index)
+{
+	assert(file);
+
+	auto entry = lookup({ file->data(), std::string(), index },
+		[&](FT_Library library, FT_Face* face)
+	{
+		return FT_New_Memory_Face(library, file->data(), FT_Long(file->size()),
+			index, face);
+	});
+
+	// The face may have been opened from the same bytes without the file,
+	// and be in use by another thread
+	if (entry)
+	{
+		std::lock_guard<std::mutex> lock(entry->mutex);
+		if (!entry->file)
+		{
+			entry->file = std::move(file);
+		}
+	}
+	return entry;
+}
+
+std::shared_ptr<ftgl::FaceCache::Entry>
+ftgl::FaceCache::open(const void* data, size_t size, long index)
+{
+	assert(data);
+
+	return lookup({ data, std::string(), index },
+		[&](FT_Library library, FT_Face* face)
+	{
+		return FT_New_Memory_Face(library, static_cast<const FT_Byte*>(data),
+			FT_Long(size), index, face);
+	});
+}
+
+std::shared_ptr<ftgl::FaceCache::Entry>
+ftgl::FaceCache::open(const std::string& path, long index)
+{
+	return lookup({ nullptr, path, index },
+		[&](FT_Library library, FT_Face* face)
+	{
+		return FT_New_Face(library, path.c_str(), index, face);
+	});
+}
+
+ftgl::FaceCache::Lease ftgl::FaceCache::acquire(
+	const std::shared_ptr<Entry>& entry,
+	float size,
+	unsigned hres,
+	unsigned vres)
+{
+	assert(entry);
+
+	std::unique_lock<std::mutex> lock(entry->mutex);
+
+	auto it = entry->sizes.find(size);
+	if (it == entry->sizes.end())
+	{
+		FT_Size ft_size;
+		FT_Error error = FT_New_Size(entry->face, &ft_size);
+		if (error)
+		{
+			report(error, __LINE__);
+			return Lease();
+		}
+
+		FT_Activate_Size(ft_size);
+		error = FT_Set_Char_Size(entry->face, FT_F26Dot6(size * 64), 0, hres, vres);
+		if (error)
+		{
+			report(error, __LINE__);
+			FT_Done_Size(ft_size);
+			return Lease();
+		}
+		entry->sizes.emplace(size, ft_size);
+	}
+	else
+	{
+		FT_Activate_Size(it->second);
+	}
+
+	return Lease(entry, std::move(lock));
+}
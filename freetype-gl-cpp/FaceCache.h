@@ -0,0 +1,122 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include "FontFile.h"
+
+//Forward declarations of freetype structs
+typedef struct FT_LibraryRec_* FT_Library;
+typedef struct FT_FaceRec_* FT_Face;
+typedef struct FT_SizeRec_* FT_Size;
+
+namespace ftgl {
+
+/**
+ * Faces shared by all the fonts created from the same source.
+ *
+ * One FT_Face is opened per (source, face index), with the Unicode charmap
+ * selected once; every point size used with it gets its own FT_Size from
+ * FT_New_Size, so a new size of a known face costs no file parsing. Each
+ * face has its own FT_Library and lock: a Lease holds that lock with the
+ * requested size active, and only one thread uses a face at a time.
+ *
+ * Faces are released with the last font referencing them.
+ */
+class FaceCache
+{
+public:
+	struct Entry
+	{
+		std::mutex mutex;
+		FT_Library library = nullptr;
+		FT_Face face = nullptr;
+
+		/** Sizes created for the face, by point size */
+		std::map<float, FT_Size> sizes;
+
+		/** Mapping the face reads from, if any */
+		std::shared_ptr<FontFile> file;
+
+		~Entry();
+	};
+
+	/**
+	 * Exclusive use of a face at one size.
+	 */
+	class Lease
+	{
+	private:
+		std::shared_ptr<Entry> m_entry;
+		std::unique_lock<std::mutex> m_lock;
+
+	public:
+		Lease() = default;
+		Lease(std::shared_ptr<Entry> entry, std::unique_lock<std::mutex> lock) :
+			m_entry(std::move(entry)), m_lock(std::move(lock))
+		{
+		}
+
+		FT_Library library() const { return m_entry->library; }
+		FT_Face face() const { return m_entry->face; }
+		explicit operator bool() const { return m_lock.owns_lock(); }
+	};
+
+	/**
+	*  Get the face of a font file mapping, a font in memory or a font file
+	*  read through its path, opening it if no font uses it yet.
+	*
+	*  @return the face, or null if it could not be opened
+	*/
+	static std::shared_ptr<Entry> open(std::shared_ptr<FontFile> file, long index);
+	static std::shared_ptr<Entry> open(const void* data, size_t size, long index);
+	static std::shared_ptr<Entry> open(const std::string& path, long index);
+
+	/**
+	*  Lock a face and activate a size of it, creating the size first if
+	*  needed.
+	*
+	*  @param entry face to use
+	*  @param size  character size in points
+	*  @param hres  horizontal resolution in dpi
+	*  @param vres  vertical resolution in dpi
+	*  @return the locked face, false if the size could not be set
+	*/
+	static Lease acquire(const std::shared_ptr<Entry>& entry, float size,
+		unsigned hres, unsigned vres);
+};
+
+}//namespace ftgl
@@ -0,0 +1,145 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "FontFile.h"
+#include <map>
+#include <mutex>
+
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace {
+
+// Files currently mapped, by path
+std::mutex registry_mutex;
+std::map<std::string, std::weak_ptr<ftgl::FontFile>> registry;
+
+}// namespace
+
+ftgl::FontFile::~FontFile()
+{
+	if (!m_data) return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_data);
+	CloseHandle(m_mapping);
+#else
+	munmap(const_cast<unsigned char*>(m_data), m_size);
+#endif
+
+	// Drop the entry, unless the file was opened again in the meantime
+	std::lock_guard<std::mutex> lock(registry_mutex);
+	auto entry = registry.find(m_path);
+	if (entry != registry.end() && entry->second.expired())
+	{
+		registry.erase(entry);
+	}
+}
+
+std::shared_ptr<ftgl::FontFile> ftgl::FontFile::open(const char* filename)
+{
+	std::lock_guard<std::mutex> lock(registry_mutex);
+
+	auto entry = registry.find(filename);
+	if (entry != registry.end())
+	{
+		if (auto file = entry->second.lock())
+		{
+			return file;
+		}
+		registry.erase(entry);
+	}
+
+	std::shared_ptr<FontFile> file(new FontFile());
+	file->m_path = filename;
+
+#ifdef _WIN32
+	HANDLE handle = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (handle == INVALID_HANDLE_VALUE)
+		return nullptr;
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(handle, &size) && size.QuadPart > 0)
+	{
+		file->m_mapping = CreateFileMappingA(handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (file->m_mapping)
+		{
+			file->m_data = static_cast<const unsigned char*>(
+				MapViewOfFile(file->m_mapping, FILE_MAP_READ, 0, 0, 0));
+			if (file->m_data)
+			{
+				file->m_size = size_t(size.QuadPart);
+			}
+			else
+			{
+				CloseHandle(file->m_mapping);
+			}
+		}
+	}
+	// The mapping keeps the file open
+	CloseHandle(handle);
+#else
+	int fd = ::open(filename, O_RDONLY);
+	if (fd < 0)
+		return nullptr;
+
+	struct stat info;
+	if (fstat(fd, &info) == 0 && info.st_size > 0)
+	{
+		void* data = mmap(nullptr, size_t(info.st_size), PROT_READ, MAP_SHARED, fd, 0);
+		if (data != MAP_FAILED)
+		{
+			file->m_data = static_cast<const unsigned char*>(data);
+			file->m_size = size_t(info.st_size);
+		}
+	}
+	// The mapping keeps the file open
+	close(fd);
+#endif
+
+	if (!file->m_data)
+		return nullptr;
+
+	registry.emplace(file->m_path, file);
+	return file;
+}
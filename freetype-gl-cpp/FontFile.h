@@ -0,0 +1,101 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace ftgl {
+
+/**
+ * A font file mapped read-only into memory.
+ *
+ * The mapping is handed to FT_New_Memory_Face, so FreeType reads the font
+ * straight from the page cache without a stream of its own. Files are
+ * shared by path: opening a file that is still mapped returns the existing
+ * mapping, which stays alive as long as a font references it.
+ *
+ * @code
+ * auto file = ftgl::FontFile::open("DejaVuSans.ttf");
+ * ftgl::Font small(&atlas, 12, file);
+ * ftgl::Font large(&atlas, 32, file);
+ * @endcode
+ */
+class FontFile
+{
+private:
+	/**
+	* Mapped bytes of the file
+	*/
+	const unsigned char* m_data = nullptr;
+
+	/**
+	* Size of the file in bytes
+	*/
+	size_t m_size = 0;
+
+	/**
+	* Path the file was opened with
+	*/
+	std::string m_path;
+
+#ifdef _WIN32
+	/**
+	* Handle of the file mapping object
+	*/
+	void* m_mapping = nullptr;
+#endif
+
+	FontFile() = default;
+
+public:
+	~FontFile();
+
+	FontFile(const FontFile&) = delete;
+	FontFile& operator=(const FontFile&) = delete;
+
+	/**
+	*  Map a font file, or share the mapping of a file already open.
+	*
+	*  @param filename path of the font file
+	*  @return the mapping, or null if the file could not be mapped
+	*/
+	static std::shared_ptr<FontFile> open(const char* filename);
+
+	const unsigned char* data() const { return m_data; }
+	size_t size() const { return m_size; }
+	const std::string& path() const { return m_path; }
+};
+
+}//namespace ftgl
@@ -0,0 +1,307 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "GlyphInstanceBuffer.h"
+#include <cstddef>
+#include <cassert>
+#include <cmath>
+#include <algorithm>
+#include "TextureFont.h"
+#include "VertexBuffer.h"
+#include "VertexFormat.h"
+
+namespace {
+
+struct InstanceFormat
+{
+	using vertex_type = ftgl::GlyphInstance;
+	static constexpr ftgl::VertexField fields[] = {
+		ftgl::vertexField<float[2]>("position", offsetof(ftgl::GlyphInstance, x)),
+		ftgl::vertexField<int16_t[2]>("size", offsetof(ftgl::GlyphInstance, width)),
+		ftgl::vertexField<uint16_t[4]>("tex_rect", offsetof(ftgl::GlyphInstance, s0), true),
+		ftgl::vertexField<uint8_t[4]>("color", offsetof(ftgl::GlyphInstance, color), true),
+		ftgl::vertexField<float>("layer", offsetof(ftgl::GlyphInstance, layer)),
+	};
+};
+
+static_assert(ftgl::validVertexFormat<InstanceFormat>(),
+	"GlyphInstance fields overlap");
+
+uint16_t to_unorm16(float value)
+{
+	return uint16_t(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+void set_color(ftgl::GlyphInstance& instance, uint32_t color)
+{
+	instance.color[0] = uint8_t(color >> 24);
+	instance.color[1] = uint8_t(color >> 16);
+	instance.color[2] = uint8_t(color >> 8);
+	instance.color[3] = uint8_t(color);
+}
+
+}
+
+const char* const ftgl::GlyphInstanceBuffer::VERTEX_SHADER = R"(#version 330
+uniform mat4 projection;
+in vec2 position;
+in vec2 size;
+in vec4 tex_rect;
+in vec4 color;
+out vec2 v_tex_coord;
+out vec4 v_color;
+void main()
+{
+	// Triangle strip over the corners (0,0) (1,0) (0,1) (1,1)
+	vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);
+	v_tex_coord = mix(tex_rect.xy, tex_rect.zw, corner);
+	v_color = color;
+	gl_Position = projection *
+		vec4(position + vec2(corner.x, -corner.y) * size, 0.0, 1.0);
+}
+)";
+
+const char* const ftgl::GlyphInstanceBuffer::FRAGMENT_SHADER = R"(#version 330
+uniform sampler2D atlas;
+in vec2 v_tex_coord;
+in vec4 v_color;
+out vec4 frag_color;
+void main()
+{
+	float a = texture(atlas, v_tex_coord).r;
+	frag_color = vec4(v_color.rgb, v_color.a * a);
+}
+)";
+
+ftgl::GlyphInstanceBuffer::GlyphInstanceBuffer()
+{
+	for (auto&& field : InstanceFormat::fields)
+	{
+		m_attributes.emplace_back(field.name, field.size, field.type,
+			field.normalized, sizeof(GlyphInstance),
+			reinterpret_cast<void*>(field.offset));
+	}
+}
+
+ftgl::GlyphInstanceBuffer::~GlyphInstanceBuffer()
+{
+	if (m_id)
+	{
+		glDeleteBuffers(1, &m_id);
+	}
+#ifdef FREETYPE_GL_USE_VAO
+	if (m_vao)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+#endif
+}
+
+size_t ftgl::GlyphInstanceBuffer::add(const Glyph& glyph, float x, float y,
+	uint32_t color, float layer)
+{
+	GlyphInstance instance;
+	instance.x = x + glyph.offset_x;
+	instance.y = y + glyph.offset_y;
+	instance.width = int16_t(glyph.width);
+	instance.height = int16_t(glyph.height);
+	instance.s0 = to_unorm16(glyph.s0);
+	instance.t0 = to_unorm16(glyph.t0);
+	instance.s1 = to_unorm16(glyph.s1);
+	instance.t1 = to_unorm16(glyph.t1);
+	set_color(instance, color);
+	instance.layer = layer;
+
+	m_instances.push_back(instance);
+	m_dirty = true;
+	return m_instances.size() - 1;
+}
+
+size_t ftgl::GlyphInstanceBuffer::add(const GlyphMetrics& metrics, float x,
+	float y, uint32_t color, float layer)
+{
+	GlyphInstance instance;
+	instance.x = x + metrics.offset_x;
+	instance.y = y + metrics.offset_y;
+	instance.width = int16_t(metrics.width);
+	instance.height = int16_t(metrics.height);
+	instance.s0 = metrics.s0;
+	instance.t0 = metrics.t0;
+	instance.s1 = metrics.s1;
+	instance.t1 = metrics.t1;
+	set_color(instance, color);
+	instance.layer = layer;
+
+	m_instances.push_back(instance);
+	m_dirty = true;
+	return m_instances.size() - 1;
+}
+
+float ftgl::GlyphInstanceBuffer::addText(Font& font, const char* text,
+	float x, float y, uint32_t color, float layer)
+{
+	std::vector<GlyphMetrics> metrics;
+	font.getMetrics(text, metrics);
+
+	m_instances.reserve(m_instances.size() + metrics.size());
+	for (size_t i = 0; i < metrics.size(); ++i)
+	{
+		if (i > 0)
+		{
+			x += font.getGlyphAt(metrics[i].index)->getKerning(
+				metrics[i - 1].codepoint);
+		}
+		add(metrics[i], x, y, color, layer);
+		x += metrics[i].advanceX();
+	}
+	return x;
+}
+
+void ftgl::GlyphInstanceBuffer::setColor(size_t index, uint32_t color)
+{
+	assert(index < m_instances.size());
+
+	set_color(m_instances[index], color);
+	m_dirty = true;
+}
+
+void ftgl::GlyphInstanceBuffer::clear()
+{
+	m_instances.clear();
+	m_dirty = true;
+}
+
+void ftgl::GlyphInstanceBuffer::upload()
+{
+	if (!m_dirty)
+		return;
+
+	if (!m_id)
+	{
+		glGenBuffers(1, &m_id);
+	}
+
+	size_t size = m_instances.size() * sizeof(GlyphInstance);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+	if (size > m_gpu_size)
+	{
+		glBufferData(GL_ARRAY_BUFFER, size, m_instances.data(), GL_DYNAMIC_DRAW);
+		m_gpu_size = size;
+	}
+	else if (size)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, 0, size, m_instances.data());
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_dirty = false;
+}
+
+void ftgl::GlyphInstanceBuffer::render()
+{
+	upload();
+
+	if (m_instances.empty())
+		return;
+
+	GLint program = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+
+#ifdef FREETYPE_GL_USE_VAO
+	if (!m_vao || m_vao_program != GLuint(program))
+	{
+		// Generate and set up the VAO, or set it up again for the attribute
+		// locations of another program
+		if (!m_vao)
+		{
+			glGenVertexArrays(1, &m_vao);
+		}
+		glBindVertexArray(m_vao);
+
+		glBindBuffer(GL_ARRAY_BUFFER, m_id);
+
+		// Disable the locations of the previous program first, they may
+		// be reused by other attributes in this one
+		for (auto&& attribute : m_attributes)
+		{
+			attribute.disable();
+		}
+		enableAttributes(GLuint(program));
+		m_vao_program = GLuint(program);
+
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+	glBindVertexArray(m_vao);
+#else
+	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+	enableAttributes(GLuint(program));
+#endif
+
+	glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, GLsizei(m_instances.size()));
+
+#ifdef FREETYPE_GL_USE_VAO
+	glBindVertexArray(0);
+#else
+	for (auto&& attribute : m_attributes)
+	{
+		if (attribute.getIndex() != -1)
+		{
+			glVertexAttribDivisor(attribute.getIndex(), 0);
+			glDisableVertexAttribArray(attribute.getIndex());
+		}
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+#endif
+}
+
+void ftgl::GlyphInstanceBuffer::enableAttributes(GLuint program)
+{
+	for (auto&& attribute : m_attributes)
+	{
+		attribute.enable(program);
+		if (attribute.getIndex() != -1)
+		{
+			glVertexAttribDivisor(attribute.getIndex(), 1);
+		}
+	}
+}
+
+void ftgl::GlyphInstanceBuffer::abandon()
+{
+	m_id = 0;
+	m_vao = 0;
+	m_vao_program = 0;
+	m_gpu_size = 0;
+	m_dirty = true;
+}
@@ -0,0 +1,208 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "opengl.h"
+#include "GlyphMetrics.h"
+#include "VertexAttribute.h"
+
+namespace ftgl {
+
+struct Glyph;
+class Font;
+
+/**
+ * One glyph to draw, as read by the instanced vertex shader.
+ *
+ * 28 bytes, against 4 vertices of 36 bytes and 6 indices for a quad in
+ * the "vertex:3f,tex_coord:2f,color:4f" format.
+ */
+struct GlyphInstance
+{
+	/**
+	* Top-left corner of the glyph bitmap, in pixels, y going up.
+	*/
+	float x;
+	float y;
+
+	/**
+	* Size of the bitmap in pixels.
+	*/
+	int16_t width;
+	int16_t height;
+
+	/**
+	* Texture coordinates of the top-left and bottom-right corners, scaled
+	* to 0..65535.
+	*/
+	uint16_t s0;
+	uint16_t t0;
+	uint16_t s1;
+	uint16_t t1;
+
+	/**
+	* Color, 8 bits per channel in RGBA order.
+	*/
+	uint8_t color[4];
+
+	/**
+	* Free for the shader, e.g. a texture array layer or a depth.
+	*/
+	float layer;
+};
+
+static_assert(sizeof(GlyphInstance) == 28, "GlyphInstance must stay 28 bytes");
+
+/**
+ * Glyphs drawn as instances of a single quad.
+ *
+ * Each glyph is a GlyphInstance; VERTEX_SHADER builds its quad from
+ * gl_VertexID, so the buffer holds no per-corner data and no indices.
+ * The shader program reads the attributes position, size, tex_rect and
+ * color, and layer if it needs it; VERTEX_SHADER and FRAGMENT_SHADER can
+ * be used as they are. Attribute locations are looked up in the program
+ * in use at render(), and the vertex array is set up again when it
+ * changes.
+ *
+ * @code
+ * ftgl::GlyphInstanceBuffer text;
+ * text.addText(font, "Hello", 10, 20, 0xffffffff);
+ * glUseProgram(program);
+ * text.render();
+ * @endcode
+ */
+class GlyphInstanceBuffer
+{
+private:
+	/**
+	* Instances to draw
+	*/
+	std::vector<GlyphInstance> m_instances;
+
+	/**
+	* Attributes of GlyphInstance, advanced once per instance
+	*/
+	std::vector<VertexAttribute> m_attributes;
+
+	/**
+	* GL identities of the instance buffer and its vertex array
+	*/
+	GLuint m_id = 0;
+	GLuint m_vao = 0;
+
+	/**
+	* Program whose attribute locations the vertex array was set up with
+	*/
+	GLuint m_vao_program = 0;
+
+	/**
+	* Size of the instance buffer on the GPU, in bytes
+	*/
+	size_t m_gpu_size = 0;
+
+	/**
+	* Whether instances changed since the last upload
+	*/
+	bool m_dirty = true;
+
+public:
+	/**
+	* GLSL 3.30 shaders drawing the instances with the atlas bound to the
+	* "atlas" sampler and a "projection" matrix; they ignore layer.
+	*/
+	static const char* const VERTEX_SHADER;
+	static const char* const FRAGMENT_SHADER;
+
+	GlyphInstanceBuffer();
+	~GlyphInstanceBuffer();
+
+	GlyphInstanceBuffer(const GlyphInstanceBuffer&) = delete;
+	GlyphInstanceBuffer& operator=(const GlyphInstanceBuffer&) = delete;
+
+	size_t size() const { return m_instances.size(); }
+
+	/**
+	*  Add a glyph with its origin at (x, y).
+	*
+	*  @param color  RGBA color, red in the most significant byte
+	*  @return index of the instance
+	*/
+	size_t add(const Glyph& glyph, float x, float y, uint32_t color,
+		float layer = 0.0f);
+	size_t add(const GlyphMetrics& metrics, float x, float y, uint32_t color,
+		float layer = 0.0f);
+
+	/**
+	*  Add the glyphs of a string starting at (x, y), with kerning.
+	*
+	*  @return x position of the pen after the string
+	*/
+	float addText(Font& font, const char* text, float x, float y,
+		uint32_t color, float layer = 0.0f);
+
+	/**
+	*  Change the color of an instance.
+	*/
+	void setColor(size_t index, uint32_t color);
+
+	void clear();
+
+	/**
+	*  Send the instances if they changed since the last upload.
+	*/
+	void upload();
+
+	/**
+	*  Draw all instances with the current program, uploading them first
+	*  if needed.
+	*/
+	void render();
+
+	/**
+	*  Forget the GL objects without deleting them, for when the context
+	*  that owned them is gone.
+	*/
+	void abandon();
+
+private:
+	/**
+	*  Enable the attributes at their locations in program, advancing once
+	*  per instance.
+	*/
+	void enableAttributes(GLuint program);
+};
+
+}//namespace ftgl
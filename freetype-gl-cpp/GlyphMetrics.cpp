@@ -0,0 +1,91 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "GlyphMetrics.h"
+#include <cmath>
+#include <algorithm>
+#include "TextureFont.h"
+
+static int16_t to_int16(int value)
+{
+	return int16_t(std::min(std::max(value, INT16_MIN), INT16_MAX));
+}
+
+static uint16_t to_uint16(size_t value)
+{
+	return uint16_t(std::min<size_t>(value, UINT16_MAX));
+}
+
+static int32_t to_fixed(float value)
+{
+	return int32_t(std::lround(value * 65536.0f));
+}
+
+static uint16_t to_unorm16(float value)
+{
+	return uint16_t(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+size_t ftgl::GlyphMetricsStore::push_back(const Glyph& glyph)
+{
+	m_codepoints.push_back(glyph.codepoint);
+	m_boxes.push_back({ to_int16(glyph.offset_x), to_int16(glyph.offset_y),
+		to_uint16(glyph.width), to_uint16(glyph.height) });
+	m_advances.push_back({ to_fixed(glyph.advance_x), to_fixed(glyph.advance_y) });
+	m_coords.push_back({ to_unorm16(glyph.s0), to_unorm16(glyph.t0),
+		to_unorm16(glyph.s1), to_unorm16(glyph.t1) });
+
+	return m_codepoints.size() - 1;
+}
+
+ftgl::GlyphMetrics ftgl::GlyphMetricsStore::operator[](size_t index) const
+{
+	const Box& box = m_boxes[index];
+	const Advance& advance = m_advances[index];
+	const Coords& coords = m_coords[index];
+
+	GlyphMetrics metrics;
+	metrics.codepoint = m_codepoints[index];
+	metrics.offset_x = box.offset_x;
+	metrics.offset_y = box.offset_y;
+	metrics.width = box.width;
+	metrics.height = box.height;
+	metrics.advance_x = advance.x;
+	metrics.advance_y = advance.y;
+	metrics.s0 = coords.s0;
+	metrics.t0 = coords.t0;
+	metrics.s1 = coords.s1;
+	metrics.t1 = coords.t1;
+	metrics.index = uint32_t(index);
+	return metrics;
+}
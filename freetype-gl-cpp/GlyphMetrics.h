@@ -0,0 +1,161 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace ftgl {
+
+struct Glyph;
+
+/**
+ * Compact copy of the layout metrics of a glyph.
+ *
+ * This is what a layout loop reads for every glyph of a text: two of them
+ * fit in a cache line, against more than 80 bytes for a Glyph. Offsets and
+ * sizes are 16 bit integers, advances are 16.16 fixed point and texture
+ * coordinates are normalized 16 bit integers; the accessors convert them
+ * back to floats.
+ */
+struct GlyphMetrics
+{
+	/**
+	* Unicode codepoint in UTF-32 LE encoding.
+	*/
+	uint32_t codepoint;
+
+	/**
+	* Left and top bearings, in integer pixels.
+	*/
+	int16_t offset_x;
+	int16_t offset_y;
+
+	/**
+	* Size of the bitmap, in pixels.
+	*/
+	uint16_t width;
+	uint16_t height;
+
+	/**
+	* Pen increments, in 16.16 fixed point pixels.
+	*/
+	int32_t advance_x;
+	int32_t advance_y;
+
+	/**
+	* Texture coordinates of the top-left and bottom-right corners, scaled
+	* to 0..65535.
+	*/
+	uint16_t s0;
+	uint16_t t0;
+	uint16_t s1;
+	uint16_t t1;
+
+	/**
+	* Index of the glyph in its font, to reach the rest of its data through
+	* Font::getGlyphAt.
+	*/
+	uint32_t index;
+
+	float advanceX() const { return advance_x / 65536.0f; }
+	float advanceY() const { return advance_y / 65536.0f; }
+
+	float S0() const { return s0 / 65535.0f; }
+	float T0() const { return t0 / 65535.0f; }
+	float S1() const { return s1 / 65535.0f; }
+	float T1() const { return t1 / 65535.0f; }
+};
+
+static_assert(sizeof(GlyphMetrics) == 32, "GlyphMetrics must stay 32 bytes");
+
+/**
+ * Layout metrics of the glyphs of a font, stored field by field.
+ *
+ * Entry i holds the metrics of the i-th glyph of the font. Each field has
+ * its own array, so a loop that only needs some of them (e.g. codepoints
+ * to find a glyph, advances to measure a string) only streams those
+ * through the cache.
+ *
+ * Like the glyphs they describe, entries never change once appended.
+ */
+class GlyphMetricsStore
+{
+private:
+	struct Box
+	{
+		int16_t offset_x;
+		int16_t offset_y;
+		uint16_t width;
+		uint16_t height;
+	};
+
+	struct Advance
+	{
+		int32_t x;
+		int32_t y;
+	};
+
+	struct Coords
+	{
+		uint16_t s0;
+		uint16_t t0;
+		uint16_t s1;
+		uint16_t t1;
+	};
+
+	std::vector<uint32_t> m_codepoints;
+	std::vector<Box> m_boxes;
+	std::vector<Advance> m_advances;
+	std::vector<Coords> m_coords;
+
+public:
+	/**
+	*  Append the metrics of a glyph.
+	*
+	*  @return index of the new entry
+	*/
+	size_t push_back(const Glyph& glyph);
+
+	/**
+	*  Compact view of entry index.
+	*/
+	GlyphMetrics operator[](size_t index) const;
+
+	size_t size() const { return m_codepoints.size(); }
+
+	const uint32_t* codepoints() const { return m_codepoints.data(); }
+};
+
+}//namespace ftgl
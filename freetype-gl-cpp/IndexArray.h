@@ -0,0 +1,199 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "opengl.h"
+
+namespace ftgl {
+
+/**
+ * Vertex indices stored on 16 bits while they all fit, on 32 bits after.
+ *
+ * The array starts with 16-bit indices and is promoted for good to 32-bit
+ * ones as soon as an index above 65535 is stored; clear() brings it back
+ * to 16 bits. type() gives the matching GL type for glDrawElements.
+ */
+class IndexArray
+{
+private:
+	std::vector<uint16_t> short_indices;
+	std::vector<GLuint> long_indices;
+	bool wide = false;
+
+	static constexpr GLuint SHORT_MAX = 0xffff;
+
+	void promote()
+	{
+		long_indices.assign(short_indices.begin(), short_indices.end());
+		short_indices = std::vector<uint16_t>();
+		wide = true;
+	}
+
+public:
+	size_t size() const
+	{
+		return wide ? long_indices.size() : short_indices.size();
+	}
+
+	bool empty() const
+	{
+		return size() == 0;
+	}
+
+	/** GL_UNSIGNED_SHORT or GL_UNSIGNED_INT */
+	GLenum type() const
+	{
+		return wide ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	}
+
+	/** Size of an index in bytes */
+	size_t elementSize() const
+	{
+		return wide ? sizeof(GLuint) : sizeof(uint16_t);
+	}
+
+	const void* data() const
+	{
+		return wide ? (const void*)long_indices.data() :
+			(const void*)short_indices.data();
+	}
+
+	GLuint operator[](size_t i) const
+	{
+		assert(i < size());
+		return wide ? long_indices[i] : short_indices[i];
+	}
+
+	void set(size_t i, GLuint index)
+	{
+		assert(i < size());
+		if (!wide && index > SHORT_MAX)
+		{
+			promote();
+		}
+
+		if (wide)
+		{
+			long_indices[i] = index;
+		}
+		else
+		{
+			short_indices[i] = uint16_t(index);
+		}
+	}
+
+	void push_back(GLuint index)
+	{
+		resize(size() + 1);
+		set(size() - 1, index);
+	}
+
+	/** Append count indices, each plus base */
+	void append(const GLuint* pindices, size_t count, GLuint base = 0)
+	{
+		size_t end = size();
+		resize(end + count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			set(end + i, pindices[i] + base);
+		}
+	}
+
+	/** Set the indices in [first, last) to index */
+	void fill(size_t first, size_t last, GLuint index)
+	{
+		for (size_t i = first; i < last; ++i)
+		{
+			set(i, index);
+		}
+	}
+
+	void erase(size_t first, size_t last)
+	{
+		if (wide)
+		{
+			long_indices.erase(long_indices.begin() + first,
+				long_indices.begin() + last);
+		}
+		else
+		{
+			short_indices.erase(short_indices.begin() + first,
+				short_indices.begin() + last);
+		}
+	}
+
+	void resize(size_t count)
+	{
+		if (wide)
+		{
+			long_indices.resize(count);
+		}
+		else
+		{
+			short_indices.resize(count);
+		}
+	}
+
+	void reserve(size_t count)
+	{
+		if (wide)
+		{
+			long_indices.reserve(count);
+		}
+		else
+		{
+			short_indices.reserve(count);
+		}
+	}
+
+	void clear()
+	{
+		short_indices.clear();
+		long_indices = std::vector<GLuint>();
+		wide = false;
+	}
+
+	void swap(IndexArray& other)
+	{
+		short_indices.swap(other.short_indices);
+		long_indices.swap(other.long_indices);
+		std::swap(wide, other.wide);
+	}
+};
+
+}//namespace ftgl
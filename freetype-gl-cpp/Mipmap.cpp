@@ -0,0 +1,125 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "Mipmap.h"
+#include "Simd.h"
+
+// Reduce one destination row from the two source rows above and below it.
+// Each vector step reads its source bytes before storing fewer destination
+// bytes, which lets the reduction run in place.
+static void mipmap_row(const unsigned char* a, const unsigned char* b,
+                       unsigned char* dst, size_t width, size_t depth)
+{
+	size_t i = 0;
+
+#if defined(FTGL_SSE2)
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i two = _mm_set1_epi16(2);
+
+	if (depth == 1)
+	{
+		const __m128i even = _mm_set1_epi16(0x00ff);
+		for (; i + 8 <= width; i += 8)
+		{
+			__m128i ra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 2 * i));
+			__m128i rb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 2 * i));
+			__m128i sum = _mm_add_epi16(
+				_mm_add_epi16(_mm_and_si128(ra, even), _mm_srli_epi16(ra, 8)),
+				_mm_add_epi16(_mm_and_si128(rb, even), _mm_srli_epi16(rb, 8)));
+			sum = _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(sum, zero));
+		}
+	}
+	else if (depth == 4)
+	{
+		for (; i + 2 <= width; i += 2)
+		{
+			__m128i ra = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + 8 * i));
+			__m128i rb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + 8 * i));
+			// Columns of two source pixels, then the pixel pairs
+			__m128i lo = _mm_add_epi16(_mm_unpacklo_epi8(ra, zero), _mm_unpacklo_epi8(rb, zero));
+			__m128i hi = _mm_add_epi16(_mm_unpackhi_epi8(ra, zero), _mm_unpackhi_epi8(rb, zero));
+			lo = _mm_add_epi16(lo, _mm_srli_si128(lo, 8));
+			hi = _mm_add_epi16(hi, _mm_srli_si128(hi, 8));
+			__m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(lo, hi), two), 2);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(dst + 4 * i), _mm_packus_epi16(sum, zero));
+		}
+	}
+#elif defined(FTGL_NEON)
+	if (depth == 1)
+	{
+		for (; i + 8 <= width; i += 8)
+		{
+			uint8x8x2_t ra = vld2_u8(a + 2 * i);
+			uint8x8x2_t rb = vld2_u8(b + 2 * i);
+			uint16x8_t sum = vaddq_u16(vaddl_u8(ra.val[0], ra.val[1]),
+				vaddl_u8(rb.val[0], rb.val[1]));
+			vst1_u8(dst + i, vrshrn_n_u16(sum, 2));
+		}
+	}
+	else if (depth == 4)
+	{
+		for (; i + 2 <= width; i += 2)
+		{
+			// Even and odd source pixels
+			uint32x2x2_t ra = vld2_u32(reinterpret_cast<const uint32_t*>(a + 8 * i));
+			uint32x2x2_t rb = vld2_u32(reinterpret_cast<const uint32_t*>(b + 8 * i));
+			uint16x8_t sum = vaddq_u16(
+				vaddl_u8(vreinterpret_u8_u32(ra.val[0]), vreinterpret_u8_u32(ra.val[1])),
+				vaddl_u8(vreinterpret_u8_u32(rb.val[0]), vreinterpret_u8_u32(rb.val[1])));
+			vst1_u8(dst + 4 * i, vrshrn_n_u16(sum, 2));
+		}
+	}
+#endif
+
+	for (; i < width; ++i)
+	{
+		for (size_t c = 0; c < depth; ++c)
+		{
+			size_t s = 2 * i * depth + c;
+			dst[i * depth + c] = static_cast<unsigned char>(
+				(a[s] + a[s + depth] + b[s] + b[s + depth] + 2) >> 2);
+		}
+	}
+}
+
+void ftgl::mipmap_downsample(const unsigned char* src, size_t src_stride,
+                             unsigned char* dst, size_t dst_stride,
+                             size_t width, size_t height, size_t depth)
+{
+	for (size_t y = 0; y < height; ++y)
+	{
+		const unsigned char* a = src + 2 * y * src_stride;
+		mipmap_row(a, a + src_stride, dst + y * dst_stride, width, depth);
+	}
+}
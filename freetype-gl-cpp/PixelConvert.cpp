@@ -0,0 +1,216 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "PixelConvert.h"
+#include "Simd.h"
+
+// Pixels looked up at once before a vector expansion
+static constexpr size_t LUT_CHUNK = 64;
+
+void ftgl::convert_gray_lut(const unsigned char* src, unsigned char* dst,
+                            size_t count, const unsigned char* lut)
+{
+	// No gather below AVX2, unrolled lookups do as well
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		unsigned char a = lut[src[i]];
+		unsigned char b = lut[src[i + 1]];
+		unsigned char c = lut[src[i + 2]];
+		unsigned char d = lut[src[i + 3]];
+		dst[i] = a;
+		dst[i + 1] = b;
+		dst[i + 2] = c;
+		dst[i + 3] = d;
+	}
+	for (; i < count; ++i)
+	{
+		dst[i] = lut[src[i]];
+	}
+}
+
+void ftgl::convert_gray_rgb(const unsigned char* src, unsigned char* dst,
+                            size_t count, const unsigned char* lut)
+{
+	if (lut)
+	{
+		unsigned char gray[LUT_CHUNK];
+		for (size_t i = 0; i < count; i += LUT_CHUNK)
+		{
+			size_t n = count - i < LUT_CHUNK ? count - i : LUT_CHUNK;
+			convert_gray_lut(src + i, gray, n, lut);
+			convert_gray_rgb(gray, dst + 3 * i, n);
+		}
+		return;
+	}
+
+	size_t i = 0;
+
+#if defined(FTGL_SSSE3)
+	const __m128i m0 = _mm_setr_epi8(0, 0, 0, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 5);
+	const __m128i m1 = _mm_setr_epi8(5, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 9, 9, 9, 10, 10);
+	const __m128i m2 = _mm_setr_epi8(10, 11, 11, 11, 12, 12, 12, 13, 13, 13, 14, 14, 14, 15, 15, 15);
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i* out = reinterpret_cast<__m128i*>(dst + 3 * i);
+		_mm_storeu_si128(out, _mm_shuffle_epi8(v, m0));
+		_mm_storeu_si128(out + 1, _mm_shuffle_epi8(v, m1));
+		_mm_storeu_si128(out + 2, _mm_shuffle_epi8(v, m2));
+	}
+#elif defined(FTGL_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16_t v = vld1q_u8(src + i);
+		uint8x16x3_t out = { { v, v, v } };
+		vst3q_u8(dst + 3 * i, out);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		dst[3 * i] = dst[3 * i + 1] = dst[3 * i + 2] = src[i];
+	}
+}
+
+void ftgl::convert_gray_rgba(const unsigned char* src, unsigned char* dst,
+                             size_t count, const unsigned char* lut)
+{
+	if (lut)
+	{
+		unsigned char gray[LUT_CHUNK];
+		for (size_t i = 0; i < count; i += LUT_CHUNK)
+		{
+			size_t n = count - i < LUT_CHUNK ? count - i : LUT_CHUNK;
+			convert_gray_lut(src + i, gray, n, lut);
+			convert_gray_rgba(gray, dst + 4 * i, n);
+		}
+		return;
+	}
+
+	size_t i = 0;
+
+#if defined(FTGL_SSE2)
+	for (; i + 16 <= count; i += 16)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+		__m128i lo = _mm_unpacklo_epi8(v, v);
+		__m128i hi = _mm_unpackhi_epi8(v, v);
+		__m128i* out = reinterpret_cast<__m128i*>(dst + 4 * i);
+		_mm_storeu_si128(out, _mm_unpacklo_epi16(lo, lo));
+		_mm_storeu_si128(out + 1, _mm_unpackhi_epi16(lo, lo));
+		_mm_storeu_si128(out + 2, _mm_unpacklo_epi16(hi, hi));
+		_mm_storeu_si128(out + 3, _mm_unpackhi_epi16(hi, hi));
+	}
+#elif defined(FTGL_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16_t v = vld1q_u8(src + i);
+		uint8x16x4_t out = { { v, v, v, v } };
+		vst4q_u8(dst + 4 * i, out);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		dst[4 * i] = dst[4 * i + 1] = dst[4 * i + 2] = dst[4 * i + 3] = src[i];
+	}
+}
+
+void ftgl::convert_swap3(const unsigned char* src, unsigned char* dst, size_t count)
+{
+	size_t i = 0;
+
+#if defined(FTGL_SSSE3)
+	// Five pixels per vector, the sixteenth byte is rewritten by the next one
+	const __m128i mask = _mm_setr_epi8(2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, 15);
+	for (; 3 * i + 16 <= 3 * count; i += 5)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 3 * i));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 3 * i), _mm_shuffle_epi8(v, mask));
+	}
+#elif defined(FTGL_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x3_t v = vld3q_u8(src + 3 * i);
+		uint8x16_t r = v.val[0];
+		v.val[0] = v.val[2];
+		v.val[2] = r;
+		vst3q_u8(dst + 3 * i, v);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		unsigned char r = src[3 * i];
+		dst[3 * i + 1] = src[3 * i + 1];
+		dst[3 * i] = src[3 * i + 2];
+		dst[3 * i + 2] = r;
+	}
+}
+
+void ftgl::convert_swap4(const unsigned char* src, unsigned char* dst, size_t count)
+{
+	size_t i = 0;
+
+#if defined(FTGL_SSE2)
+	const __m128i keep = _mm_set1_epi32(int(0xff00ff00));
+	const __m128i low = _mm_set1_epi32(0x000000ff);
+	for (; i + 4 <= count; i += 4)
+	{
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + 4 * i));
+		__m128i first = _mm_slli_epi32(_mm_and_si128(v, low), 16);
+		__m128i third = _mm_and_si128(_mm_srli_epi32(v, 16), low);
+		v = _mm_or_si128(_mm_and_si128(v, keep), _mm_or_si128(first, third));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + 4 * i), v);
+	}
+#elif defined(FTGL_NEON)
+	for (; i + 16 <= count; i += 16)
+	{
+		uint8x16x4_t v = vld4q_u8(src + 4 * i);
+		uint8x16_t r = v.val[0];
+		v.val[0] = v.val[2];
+		v.val[2] = r;
+		vst4q_u8(dst + 4 * i, v);
+	}
+#endif
+
+	for (; i < count; ++i)
+	{
+		unsigned char r = src[4 * i];
+		dst[4 * i + 1] = src[4 * i + 1];
+		dst[4 * i] = src[4 * i + 2];
+		dst[4 * i + 2] = r;
+		dst[4 * i + 3] = src[4 * i + 3];
+	}
+}
@@ -0,0 +1,77 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+
+namespace ftgl {
+
+/*
+ * Conversion of pixel rows between the layouts glyph bitmaps come in and
+ * the layouts atlases store. Each function converts count pixels from src
+ * to dst, which must not overlap. A lut, when given, maps every gray value
+ * before it is stored (gamma or contrast correction).
+ */
+
+// ------------------------------------------------------- convert_gray_lut ---
+void
+convert_gray_lut(const unsigned char* src, unsigned char* dst,
+                 size_t count, const unsigned char* lut)
+;
+
+// ------------------------------------------------------- convert_gray_rgb ---
+void
+convert_gray_rgb(const unsigned char* src, unsigned char* dst,
+                 size_t count, const unsigned char* lut = nullptr)
+;
+
+// ------------------------------------------------------ convert_gray_rgba ---
+// Gray coverage as premultiplied white: every channel takes the gray value.
+void
+convert_gray_rgba(const unsigned char* src, unsigned char* dst,
+                  size_t count, const unsigned char* lut = nullptr)
+;
+
+// ---------------------------------------------------------- convert_swap3 ---
+// Swap the first and third bytes of 3 byte pixels (RGB <-> BGR).
+void
+convert_swap3(const unsigned char* src, unsigned char* dst, size_t count)
+;
+
+// ---------------------------------------------------------- convert_swap4 ---
+// Swap the first and third bytes of 4 byte pixels (RGBA <-> BGRA).
+void
+convert_swap4(const unsigned char* src, unsigned char* dst, size_t count)
+;
+
+}//namespace ftgl
@@ -0,0 +1,132 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "PixelUnpackRing.h"
+#include <algorithm>
+#include <cassert>
+
+// Upper bound of a single wait on a fence, in nanoseconds
+static constexpr GLuint64 FENCE_TIMEOUT = 1000000;
+
+ftgl::PixelUnpackRing::PixelUnpackRing(size_t count) :
+	m_slots(count)
+{
+	assert(count > 0);
+}
+
+ftgl::PixelUnpackRing::~PixelUnpackRing()
+{
+	for (auto&& slot : m_slots)
+	{
+		if (slot.fence)
+		{
+			glDeleteSync(slot.fence);
+		}
+		if (slot.id)
+		{
+			glDeleteBuffers(1, &slot.id);
+		}
+	}
+}
+
+unsigned char* ftgl::PixelUnpackRing::map(size_t size)
+{
+	auto& slot = m_slots[m_current];
+
+	if (slot.fence)
+	{
+		GLenum status;
+		do
+		{
+			status = glClientWaitSync(slot.fence,
+				GL_SYNC_FLUSH_COMMANDS_BIT, FENCE_TIMEOUT);
+		} while (status == GL_TIMEOUT_EXPIRED);
+
+		glDeleteSync(slot.fence);
+		slot.fence = nullptr;
+	}
+
+	if (!slot.id)
+	{
+		glGenBuffers(1, &slot.id);
+	}
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, slot.id);
+
+	if (size > slot.size)
+	{
+		// Grow geometrically so a burst of glyphs does not reallocate every frame
+		slot.size = std::max(size, slot.size * 2);
+		glBufferData(GL_PIXEL_UNPACK_BUFFER, slot.size, nullptr, GL_STREAM_DRAW);
+	}
+
+	// The fence guarantees the GPU is no longer reading this buffer
+	auto* data = static_cast<unsigned char*>(glMapBufferRange(
+		GL_PIXEL_UNPACK_BUFFER, 0, size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT));
+
+	if (!data)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+	return data;
+}
+
+bool ftgl::PixelUnpackRing::unmap()
+{
+	if (glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_FALSE)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return false;
+	}
+	return true;
+}
+
+void ftgl::PixelUnpackRing::fence()
+{
+	auto& slot = m_slots[m_current];
+
+	slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	m_current = (m_current + 1) % m_slots.size();
+}
+
+void ftgl::PixelUnpackRing::abandon()
+{
+	for (auto&& slot : m_slots)
+	{
+		slot = Slot();
+	}
+	m_current = 0;
+}
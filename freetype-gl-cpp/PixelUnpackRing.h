@@ -0,0 +1,127 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include <vector>
+#include "opengl.h"
+
+namespace ftgl {
+
+/**
+ * Ring of pixel unpack buffers used to stream texture updates.
+ *
+ * Every upload is staged into the next buffer of the ring and the texture is
+ * then updated from buffer offsets, so the driver can return immediately and
+ * copy in the background. A fence is placed after each upload; the buffer is
+ * only written again once that fence has been signaled.
+ *
+ * Call sequence for an upload:
+ * @code
+ * unsigned char* staging = ring.map(size);
+ * // ...write pixels...
+ * if (ring.unmap())
+ * {
+ *     // ...glTexSubImage2D with offsets into the buffer...
+ *     ring.fence();
+ * }
+ * else
+ * {
+ *     // ...the staged pixels are lost, upload them from client memory...
+ * }
+ * @endcode
+ */
+class PixelUnpackRing
+{
+private:
+	struct Slot
+	{
+		/** GL identity of the buffer */
+		GLuint id = 0;
+
+		/** Allocated size in bytes */
+		size_t size = 0;
+
+		/** Signaled once the GPU is done reading the buffer */
+		GLsync fence = nullptr;
+	};
+
+	/**
+	* Buffers of the ring
+	*/
+	std::vector<Slot> m_slots;
+
+	/**
+	* Slot used by the upload in progress
+	*/
+	size_t m_current = 0;
+
+public:
+	explicit PixelUnpackRing(size_t count);
+	~PixelUnpackRing();
+
+	PixelUnpackRing(const PixelUnpackRing&) = delete;
+	PixelUnpackRing& operator=(const PixelUnpackRing&) = delete;
+
+	size_t size() const { return m_slots.size(); }
+
+	/**
+	*  Wait until the next buffer is free, bind it to GL_PIXEL_UNPACK_BUFFER
+	*  and map at least size bytes of it for writing. Returns nullptr, with
+	*  nothing bound, if the buffer could not be mapped.
+	*/
+	unsigned char* map(size_t size);
+
+	/**
+	*  Unmap the current buffer, leaving it bound for the texture updates.
+	*  Returns false, with nothing bound, if the driver lost the buffer
+	*  content while it was mapped (glUnmapBuffer returned GL_FALSE, e.g.
+	*  after a display mode change); the buffer stays current and is
+	*  reused by the next map() without a fence.
+	*/
+	bool unmap();
+
+	/**
+	*  Fence the texture updates issued from the current buffer, unbind it
+	*  and move on to the next one.
+	*/
+	void fence();
+
+	/**
+	*  Forget the buffers and fences without deleting them, for when the
+	*  context that owned them is gone.
+	*/
+	void abandon();
+};
+
+}//namespace ftgl
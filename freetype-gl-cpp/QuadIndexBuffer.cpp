@@ -0,0 +1,99 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "QuadIndexBuffer.h"
+#include <algorithm>
+#include "IndexArray.h"
+
+namespace {
+
+GLuint quad_indices_id = 0;
+size_t quad_capacity = 0;
+GLenum quad_index_type = GL_UNSIGNED_SHORT;
+
+}
+
+GLuint ftgl::QuadIndexBuffer::reserve(size_t quads)
+{
+	if (quad_indices_id && quads <= quad_capacity)
+		return quad_indices_id;
+
+	// Grow by half at least, but not past what 16-bit indices can address
+	// unless it is needed
+	size_t capacity = std::max<size_t>(quads, quad_capacity + quad_capacity / 2);
+	capacity = std::max<size_t>(capacity, 256);
+	if (quads <= SHORT_QUADS)
+	{
+		capacity = std::min(capacity, SHORT_QUADS);
+	}
+
+	static const GLuint QUAD[6] = { 0, 1, 2, 0, 2, 3 };
+
+	IndexArray indices;
+	indices.reserve(capacity * 6);
+	for (size_t i = 0; i < capacity; ++i)
+	{
+		indices.append(QUAD, 6, GLuint(i * 4));
+	}
+
+	if (!quad_indices_id)
+	{
+		glGenBuffers(1, &quad_indices_id);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_indices_id);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * indices.elementSize(),
+		indices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+
+	quad_capacity = capacity;
+	quad_index_type = indices.type();
+	return quad_indices_id;
+}
+
+GLenum ftgl::QuadIndexBuffer::type()
+{
+	return quad_index_type;
+}
+
+size_t ftgl::QuadIndexBuffer::elementSize()
+{
+	return quad_index_type == GL_UNSIGNED_INT ? sizeof(GLuint) : sizeof(GLushort);
+}
+
+void ftgl::QuadIndexBuffer::abandon()
+{
+	quad_indices_id = 0;
+	quad_capacity = 0;
+	quad_index_type = GL_UNSIGNED_SHORT;
+}
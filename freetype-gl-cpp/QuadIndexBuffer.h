@@ -0,0 +1,77 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include "opengl.h"
+
+namespace ftgl {
+
+/**
+ * Indices of a list of quads, 0,1,2 0,2,3 then the same plus 4 for each
+ * following quad, shared by all the VertexBuffers in quad-list mode.
+ *
+ * One element array buffer holds the pattern for the most quads asked so
+ * far. It grows by half at least and keeps its GL name, so the vertex
+ * arrays it is bound to stay valid. Its indices are 16-bit up to 16384
+ * quads and 32-bit beyond. Like any GL object it belongs to the context
+ * (or share group) that was current when it was created.
+ */
+class QuadIndexBuffer
+{
+public:
+	/** Largest number of quads 16-bit indices can address */
+	static constexpr size_t SHORT_QUADS = 0x10000 / 4;
+
+	/**
+	*  Make the buffer hold at least quads quads. Leaves no element array
+	*  buffer bound: call it while no vertex array is bound.
+	*
+	*  @return GL identity of the buffer
+	*/
+	static GLuint reserve(size_t quads);
+
+	/** GL_UNSIGNED_SHORT or GL_UNSIGNED_INT */
+	static GLenum type();
+
+	/** Size of an index in bytes */
+	static size_t elementSize();
+
+	/**
+	*  Forget the buffer without deleting it, for when the context that
+	*  owned it is gone.
+	*/
+	static void abandon();
+};
+
+}//namespace ftgl
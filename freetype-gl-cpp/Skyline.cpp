@@ -0,0 +1,385 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+
+
+#include <cassert>
+#include <limits>
+#include "Skyline.h"
+
+// Width (in pixels) above which fit() asks the segment tree instead of
+// walking the nodes below a region
+static constexpr size_t TREE_WIDTH = 32;
+
+ftgl::Skyline::Skyline(size_t width, size_t top, size_t bottom) :
+	m_width(width), m_top(top), m_bottom(bottom)
+{
+	assert(width > 2);
+	assert(top < bottom);
+
+	clear();
+}
+
+ftgl::Skyline::Nodes ftgl::Skyline::nodes() const
+{
+	Nodes nodes;
+	for (int i = m_head; i != -1; i = m_links[i].next)
+	{
+		nodes.push_back(Node{ m_links[i].x, m_links[i].y, m_links[i].z });
+	}
+	return nodes;
+}
+
+void ftgl::Skyline::clear()
+{
+	m_links.clear();
+	m_free = -1;
+	m_levels.assign(m_bottom + 1, -1);
+	m_occupied.assign(m_bottom / 64 + 1, 0);
+
+	m_tree = false;
+	m_max.clear();
+	m_assigned.clear();
+
+	// We want a one pixel border around the whole atlas to avoid any artefact when
+	// sampling texture
+	m_head = allocate(1, int(m_top), int(m_width) - 2);
+	m_links[m_head].prev = -1;
+	m_links[m_head].next = -1;
+}
+
+int ftgl::Skyline::allocate(int x, int y, int z)
+{
+	int index = m_free;
+	if (index == -1)
+	{
+		index = int(m_links.size());
+		m_links.emplace_back();
+	}
+	else
+	{
+		m_free = m_links[index].next;
+	}
+
+	auto& node = m_links[index];
+	node.x = x;
+	node.y = y;
+	node.z = z;
+	link(index);
+	return index;
+}
+
+void ftgl::Skyline::release(int index)
+{
+	auto& node = m_links[index];
+	unlink(index);
+
+	if (node.prev != -1) m_links[node.prev].next = node.next;
+	else m_head = node.next;
+	if (node.next != -1) m_links[node.next].prev = node.prev;
+
+	node.next = m_free;
+	m_free = index;
+}
+
+void ftgl::Skyline::link(int index)
+{
+	auto& node = m_links[index];
+	node.prev_level = -1;
+	node.next_level = m_levels[node.y];
+	if (node.next_level != -1)
+	{
+		m_links[node.next_level].prev_level = index;
+	}
+	m_levels[node.y] = index;
+	m_occupied[node.y / 64] |= uint64_t(1) << (node.y % 64);
+}
+
+void ftgl::Skyline::unlink(int index)
+{
+	auto& node = m_links[index];
+	if (node.prev_level != -1)
+	{
+		m_links[node.prev_level].next_level = node.next_level;
+	}
+	else
+	{
+		m_levels[node.y] = node.next_level;
+		if (node.next_level == -1)
+		{
+			m_occupied[node.y / 64] &= ~(uint64_t(1) << (node.y % 64));
+		}
+	}
+	if (node.next_level != -1)
+	{
+		m_links[node.next_level].prev_level = node.prev_level;
+	}
+}
+
+int ftgl::Skyline::nextLevel(int y) const
+{
+	size_t word = y / 64;
+	if (word >= m_occupied.size()) return -1;
+
+	uint64_t bits = m_occupied[word] & (~uint64_t(0) << (y % 64));
+	while (!bits)
+	{
+		if (++word == m_occupied.size()) return -1;
+		bits = m_occupied[word];
+	}
+
+	int bit = 0;
+	while (!(bits & 1))
+	{
+		bits >>= 1;
+		++bit;
+	}
+	return int(word * 64) + bit;
+}
+
+void ftgl::Skyline::buildTree()
+{
+	m_leaves = 1;
+	while (size_t(m_leaves) < m_width)
+	{
+		m_leaves *= 2;
+	}
+	m_max.assign(2 * m_leaves, int(m_top));
+	m_assigned.assign(2 * m_leaves, -1);
+	m_assigned[1] = int(m_top);
+
+	for (int i = m_head; i != -1; i = m_links[i].next)
+	{
+		auto& node = m_links[i];
+		raise(1, 0, m_leaves, node.x, node.x + node.z, node.y);
+	}
+	m_tree = true;
+}
+
+int ftgl::Skyline::highest(int node, int lo, int hi, int first, int last) const
+{
+	// Columns [lo, hi) of the node, looking for the highest in [first, last)
+	if (m_assigned[node] != -1 || (first <= lo && hi <= last))
+	{
+		return m_assigned[node] != -1 ? m_assigned[node] : m_max[node];
+	}
+
+	int mid = (lo + hi) / 2;
+	int y = 0;
+	if (first < mid)
+	{
+		y = highest(2 * node, lo, mid, first, last);
+	}
+	if (last > mid)
+	{
+		int right = highest(2 * node + 1, mid, hi, first, last);
+		if (right > y)
+		{
+			y = right;
+		}
+	}
+	return y;
+}
+
+void ftgl::Skyline::raise(int node, int lo, int hi, int first, int last, int y)
+{
+	if (first <= lo && hi <= last)
+	{
+		m_max[node] = y;
+		m_assigned[node] = y;
+		return;
+	}
+
+	// Push a whole-segment value down before changing part of it
+	if (m_assigned[node] != -1)
+	{
+		for (int child : { 2 * node, 2 * node + 1 })
+		{
+			m_max[child] = m_assigned[node];
+			m_assigned[child] = m_assigned[node];
+		}
+		m_assigned[node] = -1;
+	}
+
+	int mid = (lo + hi) / 2;
+	if (first < mid)
+	{
+		raise(2 * node, lo, mid, first, last, y);
+	}
+	if (last > mid)
+	{
+		raise(2 * node + 1, mid, hi, first, last, y);
+	}
+	m_max[node] = m_max[2 * node] > m_max[2 * node + 1] ?
+		m_max[2 * node] : m_max[2 * node + 1];
+}
+
+int ftgl::Skyline::fit(
+	      int index,
+	const size_t width,
+	const size_t height,
+	const size_t best_height)
+{
+	int width_left = int(width);
+	int x = m_links[index].x;
+	int y = m_links[index].y;
+
+	if ((x + width) > (m_width - 1))
+	{
+		return -1;
+	}
+
+	// Glyphs cover a few nodes and walk them, wider regions ask the tree
+	if (width > TREE_WIDTH)
+	{
+		if (!m_tree)
+		{
+			buildTree();
+		}
+		y = highest(1, 0, m_leaves, x, x + int(width));
+		return ((y + height) > m_bottom) || ((y + height) > best_height) ? -1 : y;
+	}
+
+	while (width_left > 0)
+	{
+		assert(index != -1);
+
+		auto& node = m_links[index];
+		if (node.y > y)
+		{
+			y = node.y;
+		}
+		// Give up as soon as the region can neither fit nor beat the best one
+		if (((y + height) > m_bottom) || ((y + height) > best_height))
+		{
+			return -1;
+		}
+		width_left -= node.z;
+		index = node.next;
+	}
+	return y;
+}
+
+ftgl::ivec4 ftgl::Skyline::getRegion(size_t width, size_t height)
+{
+	ftgl::ivec4 region = { {0, 0, int(width), int(height)} };
+
+	size_t best_height = std::numeric_limits<size_t>::max();
+	size_t best_width = std::numeric_limits<size_t>::max();
+	int best_index = -1;
+
+	// Nodes are visited from the lowest level up: a region starting on a node
+	// can never land below that node, so once a level is higher than the best
+	// candidate found so far no later node can improve on it.
+	for (int level = nextLevel(0); level != -1; level = nextLevel(level + 1))
+	{
+		if (level + height > best_height) break;
+
+		for (int i = m_levels[level]; i != -1; i = m_links[i].next_level)
+		{
+			auto& node = m_links[i];
+			int y = fit(i, width, height, best_height);
+			if (y < 0) continue;
+
+			// Ties keep the narrowest node, then the leftmost one
+			if (((y + height) < best_height)
+				|| (((y + height) == best_height)
+					&& ((size_t(node.z) < best_width)
+						|| ((size_t(node.z) == best_width)
+							&& (node.x < m_links[best_index].x)))))
+			{
+				best_height = y + height;
+				best_width = node.z;
+				best_index = i;
+				region.x = node.x;
+				region.y = y;
+			}
+		}
+	}
+
+	if (best_index == -1)
+	{
+		region.x = -1;
+		region.y = -1;
+		region.width = 0;
+		region.height = 0;
+		return region;
+	}
+
+	int right = region.x + int(width);
+	int prev = m_links[best_index].prev;
+
+	if (m_tree)
+	{
+		raise(1, 0, m_leaves, region.x, right, region.y + int(height));
+	}
+
+	// Drop the nodes now covered by the new one and trim the last one
+	int i = best_index;
+	while (i != -1 && m_links[i].x < right)
+	{
+		auto& node = m_links[i];
+		if (node.x + node.z > right)
+		{
+			node.z -= right - node.x;
+			node.x = right;
+			break;
+		}
+		int next = node.next;
+		release(i);
+		i = next;
+	}
+
+	int index = allocate(region.x, region.y + int(height), int(width));
+	m_links[index].prev = prev;
+	m_links[index].next = i;
+	if (prev != -1) m_links[prev].next = index;
+	else m_head = index;
+	if (i != -1) m_links[i].prev = index;
+
+	// Merge with the neighbours at the same height
+	if (prev != -1 && m_links[prev].y == m_links[index].y)
+	{
+		m_links[index].x = m_links[prev].x;
+		m_links[index].z += m_links[prev].z;
+		release(prev);
+	}
+	int next = m_links[index].next;
+	if (next != -1 && m_links[next].y == m_links[index].y)
+	{
+		m_links[index].z += m_links[next].z;
+		release(next);
+	}
+
+	return region;
+}
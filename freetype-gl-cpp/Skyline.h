@@ -0,0 +1,180 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "vec234.h"
+
+namespace ftgl {
+
+/**
+ * Skyline Bottom-Left packer used by TextureAtlas.
+ *
+ * The skyline nodes live in a pool and are threaded on two intrusive lists:
+ * one ordered by x (the skyline itself) and one per height level. A bitmap
+ * of the non-empty levels lets the best-fit search visit the nodes from the
+ * lowest one up and stop as soon as no remaining node can beat the best
+ * candidate found so far. Splitting and merging nodes only relinks a few
+ * entries instead of shifting the whole node array.
+ *
+ * A max-height segment tree over the columns answers the fit test of a
+ * candidate in O(log width), instead of walking the nodes the region
+ * would cover, and is updated in O(log width) by each allocation. It is
+ * only built once a region wider than a glyph is asked for, so glyph
+ * workloads do not pay for its upkeep.
+ *
+ * The candidates themselves are still every node below the best fit: a
+ * node narrower than the region may still hold it, raised by its
+ * neighbours, so no node can be skipped without changing the placement.
+ */
+class Skyline
+{
+public:
+	using Node = ftgl::ivec3;
+	using Nodes = std::vector<Node>;
+
+private:
+	struct Link
+	{
+		int x, y, z;
+
+		/** Neighbours along the skyline */
+		int prev, next;
+
+		/** Neighbours at the same height */
+		int prev_level, next_level;
+	};
+
+	/**
+	* Node pool, free entries are chained through next
+	*/
+	std::vector<Link> m_links;
+
+	/**
+	* Head of the free list
+	*/
+	int m_free = -1;
+
+	/**
+	* Leftmost node
+	*/
+	int m_head = -1;
+
+	/**
+	* First node of every height level
+	*/
+	std::vector<int> m_levels;
+
+	/**
+	* One bit per height level, set when the level holds any node
+	*/
+	std::vector<uint64_t> m_occupied;
+
+	/**
+	* Segment tree over the columns: highest skyline row of each segment,
+	* and the row a whole segment was set to, -1 if it was not
+	*/
+	std::vector<int> m_max;
+	std::vector<int> m_assigned;
+
+	/**
+	* Number of leaves of the tree, a power of two
+	*/
+	int m_leaves = 1;
+
+	/**
+	* Whether the tree is built and kept up to date
+	*/
+	bool m_tree = false;
+
+	/**
+	* Width (in pixels) of the packed area, including the border
+	*/
+	size_t m_width;
+
+	/**
+	* First usable row
+	*/
+	size_t m_top;
+
+	/**
+	* One past the last usable row
+	*/
+	size_t m_bottom;
+
+public:
+	/**
+	*  Creates a skyline packing columns [1, width - 1) and rows [top, bottom).
+	*/
+	Skyline(size_t width, size_t top, size_t bottom);
+
+	size_t width() const { return m_width; }
+	size_t top() const { return m_top; }
+	size_t bottom() const { return m_bottom; }
+
+	/**
+	*  Snapshot of the current skyline, ordered by x.
+	*/
+	Nodes nodes() const;
+
+	/**
+	*  Allocate a new region.
+	*
+	*  @param width  width of the region to allocate
+	*  @param height height of the region to allocate
+	*  @return       Coordinates of the allocated region, or (-1, -1, 0, 0)
+	*                if it does not fit
+	*/
+	ftgl::ivec4 getRegion(size_t width, size_t height);
+
+	/**
+	*  Remove all allocated regions.
+	*/
+	void clear();
+
+private:
+	int fit(int index, size_t width, size_t height, size_t best_height);
+	void buildTree();
+	int allocate(int x, int y, int z);
+	void release(int index);
+	void link(int index);
+	void unlink(int index);
+	int nextLevel(int y) const;
+	int highest(int node, int lo, int hi, int first, int last) const;
+	void raise(int node, int lo, int hi, int first, int last, int y);
+};
+
+}// namespace ftgl
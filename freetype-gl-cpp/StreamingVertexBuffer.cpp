@@ -0,0 +1,315 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "StreamingVertexBuffer.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include "VertexBuffer.h"
+
+// Upper bound of a single wait on a fence, in nanoseconds
+static constexpr GLuint64 FENCE_TIMEOUT = 1000000;
+
+ftgl::StreamingVertexBuffer::StreamingVertexBuffer(const char* format,
+	size_t vertex_capacity, size_t index_capacity, bool persistent) :
+	m_vertex_capacity(vertex_capacity),
+	m_index_capacity(index_capacity),
+#ifdef GL_MAP_PERSISTENT_BIT
+	m_persistent(persistent)
+#else
+	m_persistent(false)
+#endif
+{
+	m_stride = VertexAttribute::parseFormat(format, MAX_VERTEX_ATTRIBUTES,
+		m_attributes);
+	assert(m_stride > 0);
+
+	// Indices start 4-aligned after the vertices, and partitions span whole
+	// vertices so the vertex numbers of a partition follow those of the last
+	size_t align = m_stride * sizeof(GLuint);
+	m_index_offset = (m_vertex_capacity * m_stride + 3) & ~size_t(3);
+	m_partition_size = m_index_offset + m_index_capacity * sizeof(GLuint);
+	m_partition_size = (m_partition_size + align - 1) / align * align;
+}
+
+ftgl::StreamingVertexBuffer::~StreamingVertexBuffer()
+{
+	for (auto&& fence : m_fences)
+	{
+		if (fence)
+		{
+			glDeleteSync(fence);
+		}
+	}
+	if (m_id)
+	{
+		if (m_mapped)
+		{
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			glUnmapBuffer(GL_ARRAY_BUFFER);
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &m_id);
+	}
+#ifdef FREETYPE_GL_USE_VAO
+	if (m_vao)
+	{
+		glDeleteVertexArrays(1, &m_vao);
+	}
+#endif
+}
+
+void ftgl::StreamingVertexBuffer::create()
+{
+	glGenBuffers(1, &m_id);
+	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+
+#ifdef GL_MAP_PERSISTENT_BIT
+	if (m_persistent)
+	{
+		size_t size = m_partition_size * PARTITIONS;
+
+		// Coherent, so writes need no explicit flush before the draw
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT |
+			GL_MAP_COHERENT_BIT;
+		glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+		m_mapped = static_cast<char*>(
+			glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags));
+
+		if (!m_mapped)
+		{
+			// Immutable storage cannot be respecified for the fallback
+			glBindBuffer(GL_ARRAY_BUFFER, 0);
+			glDeleteBuffers(1, &m_id);
+			glGenBuffers(1, &m_id);
+			glBindBuffer(GL_ARRAY_BUFFER, m_id);
+			m_persistent = false;
+		}
+	}
+#endif
+
+	// Without persistent mapping, begin() allocates the storage of the
+	// first round like it orphans those of the next ones
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+bool ftgl::StreamingVertexBuffer::begin()
+{
+	if (!m_id)
+	{
+		create();
+	}
+
+	m_vertex_count = 0;
+	m_index_count = 0;
+
+	if (m_persistent)
+	{
+		GLsync& fence = m_fences[m_current];
+		if (fence)
+		{
+			wait(fence);
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+		return m_mapped != nullptr;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+
+	// begin() again before render() drops the frame: release its mapping
+	// before the partition is mapped anew
+	if (m_mapped)
+	{
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		m_mapped = nullptr;
+	}
+
+	// Orphan the storage when the ring wraps around: draws of the previous
+	// round keep the old storage, and the partitions of this round are
+	// only written before the GPU reads them
+	if (m_current == 0)
+	{
+		glBufferData(GL_ARRAY_BUFFER, m_partition_size * PARTITIONS, nullptr,
+			GL_STREAM_DRAW);
+	}
+
+	m_mapped = static_cast<char*>(glMapBufferRange(GL_ARRAY_BUFFER,
+		m_current * m_partition_size, m_partition_size,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT |
+		GL_MAP_UNSYNCHRONIZED_BIT));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	return m_mapped != nullptr;
+}
+
+ftgl::StreamingVertexBuffer::Span
+ftgl::StreamingVertexBuffer::allocate(size_t vcount, size_t icount)
+{
+	if (!m_mapped ||
+		m_vertex_count + vcount > m_vertex_capacity ||
+		m_index_count + icount > m_index_capacity)
+	{
+		m_stats.overflows++;
+		return { nullptr, nullptr, 0 };
+	}
+
+	char* partition = m_mapped;
+	if (m_persistent)
+	{
+		partition += m_current * m_partition_size;
+	}
+
+	Span span;
+	span.vertices = partition + m_vertex_count * m_stride;
+	span.indices = reinterpret_cast<GLuint*>(partition + m_index_offset) +
+		m_index_count;
+	span.base = GLuint(m_current * m_partition_size / m_stride + m_vertex_count);
+
+	m_vertex_count += vcount;
+	m_index_count += icount;
+	return span;
+}
+
+void ftgl::StreamingVertexBuffer::render(GLenum mode)
+{
+	if (!m_id)
+		return;
+
+	if (!m_persistent && m_mapped)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, m_id);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		m_mapped = nullptr;
+	}
+
+#ifdef FREETYPE_GL_USE_VAO
+	if (!m_vao)
+	{
+		glGenVertexArrays(1, &m_vao);
+		glBindVertexArray(m_vao);
+
+		// Attribute offsets are from the start of the buffer, partitions
+		// are reached through the indices
+		glBindBuffer(GL_ARRAY_BUFFER, m_id);
+		for (auto&& attribute : m_attributes)
+		{
+			attribute.enable();
+		}
+		glBindBuffer(GL_ARRAY_BUFFER, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
+	}
+	glBindVertexArray(m_vao);
+#else
+	glBindBuffer(GL_ARRAY_BUFFER, m_id);
+	for (auto&& attribute : m_attributes)
+	{
+		attribute.enable();
+	}
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_id);
+#endif
+
+	if (m_index_capacity)
+	{
+		if (m_index_count)
+		{
+			glDrawElements(mode, GLsizei(m_index_count), GL_UNSIGNED_INT,
+				(void*)(m_current * m_partition_size + m_index_offset));
+		}
+	}
+	else if (m_vertex_count)
+	{
+		glDrawArrays(mode, GLint(m_current * m_partition_size / m_stride),
+			GLsizei(m_vertex_count));
+	}
+
+#ifdef FREETYPE_GL_USE_VAO
+	glBindVertexArray(0);
+#else
+	for (auto&& attribute : m_attributes)
+	{
+		attribute.disable();
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+#endif
+
+	if (m_persistent)
+	{
+		m_fences[m_current] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	m_current = (m_current + 1) % PARTITIONS;
+	m_stats.frames++;
+}
+
+void ftgl::StreamingVertexBuffer::wait(GLsync fence)
+{
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED ||
+		status == GL_WAIT_FAILED)
+	{
+		return;
+	}
+
+	// The GPU is still reading the partition: the CPU is more than
+	// PARTITIONS - 1 frames ahead
+	auto start = std::chrono::steady_clock::now();
+	do
+	{
+		status = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT,
+			FENCE_TIMEOUT);
+	} while (status == GL_TIMEOUT_EXPIRED);
+
+	uint64_t elapsed = uint64_t(std::chrono::duration_cast<
+		std::chrono::microseconds>(std::chrono::steady_clock::now() - start)
+		.count());
+	m_stats.waits++;
+	m_stats.wait_us += elapsed;
+	m_stats.max_wait_us = std::max(m_stats.max_wait_us, elapsed);
+}
+
+void ftgl::StreamingVertexBuffer::abandon()
+{
+	for (auto&& fence : m_fences)
+	{
+		fence = nullptr;
+	}
+	m_id = 0;
+	m_vao = 0;
+	m_mapped = nullptr;
+	m_current = 0;
+	m_vertex_count = 0;
+	m_index_count = 0;
+}
@@ -0,0 +1,201 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "opengl.h"
+#include "VertexAttribute.h"
+
+namespace ftgl {
+
+/**
+ * Vertex buffer for geometry rebuilt every frame, e.g. counters or debug
+ * overlays.
+ *
+ * Vertices and indices are written straight into GL memory instead of
+ * going through a std::vector and glBufferSubData. The buffer is split in
+ * three partitions used one frame after the other: with persistent
+ * mapping (GL_MAP_PERSISTENT_BIT), it stays mapped and a fence placed
+ * after each frame's draw tells when its partition may be written again.
+ * Otherwise each partition is mapped unsynchronized for the frame, and
+ * the whole buffer is orphaned when the ring wraps around.
+ *
+ * Indices are absolute: add Span::base to the indices of the vertices of
+ * a span.
+ *
+ * @code
+ * buffer.begin();
+ * auto span = buffer.allocate(4, 6);
+ * // ...write 4 vertices to span.vertices, 6 indices plus span.base to
+ * // span.indices...
+ * buffer.render(GL_TRIANGLES);
+ * @endcode
+ */
+class StreamingVertexBuffer
+{
+public:
+	/**
+	 * Room reserved by allocate(), null pointers if the frame is full.
+	 */
+	struct Span
+	{
+		char* vertices;
+		GLuint* indices;
+		GLuint base;
+	};
+
+	/**
+	 * Time spent waiting for the GPU to release partitions.
+	 */
+	struct Stats
+	{
+		/** Frames rendered */
+		size_t frames = 0;
+
+		/** Fences that were not signaled yet when their partition came back */
+		size_t waits = 0;
+
+		/** Time (in microseconds) blocked on fences, overall and at worst */
+		uint64_t wait_us = 0;
+		uint64_t max_wait_us = 0;
+
+		/** allocate() calls refused because the frame was full */
+		size_t overflows = 0;
+	};
+
+	static constexpr size_t PARTITIONS = 3;
+
+private:
+	/**
+	* Attributes of the vertices, from the format string
+	*/
+	std::vector<VertexAttribute> m_attributes;
+
+	/**
+	* Size of a vertex in bytes
+	*/
+	size_t m_stride = 0;
+
+	/**
+	* Vertices and indices a frame may hold
+	*/
+	size_t m_vertex_capacity;
+	size_t m_index_capacity;
+
+	/**
+	* Bytes of a partition, vertices first then indices; a multiple of the
+	* stride so vertex numbers line up with partitions
+	*/
+	size_t m_partition_size = 0;
+	size_t m_index_offset = 0;
+
+	/**
+	* GL identity of the buffer, bound for both vertices and indices
+	*/
+	GLuint m_id = 0;
+	GLuint m_vao = 0;
+
+	/**
+	* Whether the buffer is persistently mapped
+	*/
+	bool m_persistent;
+
+	/**
+	* Whole buffer when persistently mapped, current partition otherwise
+	*/
+	char* m_mapped = nullptr;
+
+	/**
+	* Signaled once the GPU is done with the draw of each partition
+	*/
+	GLsync m_fences[PARTITIONS] = {};
+
+	/**
+	* Partition of the current frame and what it holds so far
+	*/
+	size_t m_current = 0;
+	size_t m_vertex_count = 0;
+	size_t m_index_count = 0;
+
+	Stats m_stats;
+
+public:
+	/**
+	*  @param format            vertex format, as for VertexBuffer
+	*  @param vertex_capacity   vertices a frame may hold
+	*  @param index_capacity    indices a frame may hold
+	*  @param persistent        use a persistently mapped buffer; ignored
+	*                           if the GL headers lack GL_MAP_PERSISTENT_BIT
+	*/
+	StreamingVertexBuffer(const char* format, size_t vertex_capacity,
+		size_t index_capacity, bool persistent = true);
+	~StreamingVertexBuffer();
+
+	StreamingVertexBuffer(const StreamingVertexBuffer&) = delete;
+	StreamingVertexBuffer& operator=(const StreamingVertexBuffer&) = delete;
+
+	bool persistent() const { return m_persistent; }
+	const Stats& stats() const { return m_stats; }
+
+	/**
+	*  Start a frame: wait until the next partition is released by the GPU
+	*  and make it writable. Returns false if it could not be mapped.
+	*  Calling it again before render() drops what the frame holds.
+	*/
+	bool begin();
+
+	/**
+	*  Reserve room for vcount vertices and icount indices in the frame.
+	*/
+	Span allocate(size_t vcount, size_t icount);
+
+	/**
+	*  Draw what the frame holds, fence its partition and move on to the
+	*  next one. A shader program must be in use.
+	*/
+	void render(GLenum mode);
+
+	/**
+	*  Forget the GL objects without deleting them, for when the context
+	*  that owned them is gone.
+	*/
+	void abandon();
+
+private:
+	void create();
+	void wait(GLsync fence);
+};
+
+}//namespace ftgl
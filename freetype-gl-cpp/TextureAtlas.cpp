@@ -33,29 +33,134 @@
  */
 
 
+#include <algorithm>
 #include <cassert>
-#include <limits>
+#include <functional>
+#include <mutex>
+#include <thread>
 #include "TextureAtlas.h"
+#include "BC4.h"
+#include "Mipmap.h"
+#include "PixelConvert.h"
+#include "PixelUnpackRing.h"
 #include "opengl.h"
 
-ftgl::TextureAtlas::TextureAtlas(size_t width, size_t height, size_t depth) :
-	m_width(width), m_height(height), m_depth(depth), m_used(0), m_id(0),
-	m_data(static_cast<unsigned char*>(calloc(
-			       width*height*depth, sizeof(unsigned char))
-	       ), free)
+namespace {
+
+// Past this many separate regions a single bounding box is cheaper to send
+constexpr size_t MAX_DIRTY_REGIONS = 64;
+
+constexpr size_t TILE = ftgl::TextureAtlas::TILE_SIZE;
+
+// Stands in for the tiles that were never written to
+const unsigned char EMPTY_TILE[TILE * TILE * 4] = {};
+
+struct PixelFormat
 {
-	// We want a one pixel border around the whole atlas to avoid any artefact when
-	// sampling texture
-	m_nodes.push_back(Node{ 1, 1, int(width) - 2 });
+	GLint internal_format;
+	GLenum format;
+	GLenum type;
+};
 
-	assert((depth == 1) || (depth == 3) || (depth == 4));
+PixelFormat pixelFormat(size_t depth)
+{
+	if (depth == 4)
+	{
+#ifdef GL_UNSIGNED_INT_8_8_8_8_REV
+		return{ GL_RGBA, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV };
+#else
+		return{ GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE };
+#endif
+	}
+	else if (depth == 3)
+	{
+		return{ GL_RGB, GL_RGB, GL_UNSIGNED_BYTE };
+	}
+#if defined(GL_ES_VERSION_2_0) || defined(GL_ES_VERSION_3_0)
+	return{ GL_LUMINANCE, GL_LUMINANCE, GL_UNSIGNED_BYTE };
+#else
+	return{ GL_RED, GL_RED, GL_UNSIGNED_BYTE };
+#endif
+}
+
+template<size_t Depth>
+void copyPixels(const unsigned char* src, unsigned char* dst, size_t count,
+	const unsigned char*)
+{
+	memcpy(dst, src, count * Depth);
+}
+
+void grayLut(const unsigned char* src, unsigned char* dst, size_t count,
+	const unsigned char* lut)
+{
+	ftgl::convert_gray_lut(src, dst, count, lut);
+}
+
+void swap3(const unsigned char* src, unsigned char* dst, size_t count,
+	const unsigned char*)
+{
+	ftgl::convert_swap3(src, dst, count);
+}
+
+void swap4(const unsigned char* src, unsigned char* dst, size_t count,
+	const unsigned char*)
+{
+	ftgl::convert_swap4(src, dst, count);
+}
+
+size_t formatDepth(ftgl::TextureAtlas::Format format)
+{
+	using Format = ftgl::TextureAtlas::Format;
+	return format == Format::Gray ? 1
+		: (format == Format::RGB || format == Format::BGR) ? 3 : 4;
+}
+
+int area(const ftgl::ivec4& r)
+{
+	return r.width * r.height;
+}
+
+int overlap(const ftgl::ivec4& a, const ftgl::ivec4& b)
+{
+	int width = std::min(a.x + a.width, b.x + b.width) - std::max(a.x, b.x);
+	int height = std::min(a.y + a.height, b.y + b.height) - std::max(a.y, b.y);
+	return (width > 0 && height > 0) ? width * height : 0;
+}
+
+ftgl::ivec4 bounds(const ftgl::ivec4& a, const ftgl::ivec4& b)
+{
+	int x = std::min(a.x, b.x);
+	int y = std::min(a.y, b.y);
+	return{ { x, y,
+		std::max(a.x + a.width, b.x + b.width) - x,
+		std::max(a.y + a.height, b.y + b.height) - y } };
+}
+
+}// namespace
 
-	if (m_data == nullptr)
+/* A horizontal band of a concurrent atlas, owning the tiles it covers */
+struct ftgl::TextureAtlas::Band
+{
+	std::mutex mutex;
+	Skyline skyline;
+	std::vector<ftgl::ivec4> dirty;
+
+	/** Rows covered by the band, borders included */
+	ftgl::ivec4 rows;
+
+	Band(size_t width, size_t top, size_t bottom, const ftgl::ivec4& rows) :
+		skyline(width, top, bottom), rows(rows)
 	{
-		fprintf(stderr,
-			"line %d: No more memory for allocating data\n", __LINE__);
-		exit(EXIT_FAILURE);
 	}
+};
+
+ftgl::TextureAtlas::TextureAtlas(size_t width, size_t height, size_t depth) :
+	m_skyline(width, 1, height - 1),
+	m_width(width), m_height(height), m_depth(depth), m_used(0), m_id(0),
+	m_tiles(((width + TILE - 1) / TILE) * ((height + TILE - 1) / TILE)),
+	m_tiles_x((width + TILE - 1) / TILE)
+{
+	assert((depth == 1) || (depth == 3) || (depth == 4));
 }
 
 ftgl::TextureAtlas::~TextureAtlas()
@@ -66,6 +171,32 @@ ftgl::TextureAtlas::~TextureAtlas()
 	}
 }
 
+size_t ftgl::TextureAtlas::allocated() const
+{
+	size_t tiles = 0;
+	for (auto&& tile : m_tiles)
+	{
+		if (tile) ++tiles;
+	}
+	return tiles * TILE * TILE * m_depth;
+}
+
+unsigned char* ftgl::TextureAtlas::tileAt(size_t x, size_t y)
+{
+	auto& tile = m_tiles[(y / TILE) * m_tiles_x + x / TILE];
+	if (!tile)
+	{
+		tile.reset(new unsigned char[TILE * TILE * m_depth]());
+	}
+	return tile.get();
+}
+
+const unsigned char* ftgl::TextureAtlas::tileAt(size_t x, size_t y) const
+{
+	auto& tile = m_tiles[(y / TILE) * m_tiles_x + x / TILE];
+	return tile ? tile.get() : EMPTY_TILE;
+}
+
 void ftgl::TextureAtlas::setRegion(
 	size_t x,
 	size_t y,
@@ -73,6 +204,121 @@ void ftgl::TextureAtlas::setRegion(
 	size_t height,
 	const unsigned char * data,
 	size_t stride)
+{
+	Convert copy = m_depth == 1 ? copyPixels<1>
+		: m_depth == 3 ? copyPixels<3> : copyPixels<4>;
+	writeRegion(x, y, width, height, data, stride, m_depth, copy, nullptr);
+}
+
+bool ftgl::TextureAtlas::setRegion(
+	size_t x,
+	size_t y,
+	size_t width,
+	size_t height,
+	const unsigned char * data,
+	size_t stride,
+	Format format,
+	const unsigned char * lut)
+{
+	Convert convert = converter(format, lut);
+	if (!convert)
+		return false;
+
+	writeRegion(x, y, width, height, data, stride, formatDepth(format),
+		convert, lut);
+	return true;
+}
+
+bool ftgl::TextureAtlas::matchRegion(
+	size_t x,
+	size_t y,
+	size_t width,
+	size_t height,
+	const unsigned char * data,
+	size_t stride,
+	Format format,
+	const unsigned char * lut) const
+{
+	assert((x + width) <= m_width);
+	assert((y + height) <= m_height);
+
+	Convert convert = converter(format, lut);
+	if (!convert)
+		return false;
+
+	std::unique_lock<std::mutex> lock;
+	if (!m_bands.empty())
+	{
+		lock = std::unique_lock<std::mutex>(m_bands[y / m_band_height]->mutex);
+	}
+
+	// One tile row of converted data at a time
+	size_t data_depth = formatDepth(format);
+	unsigned char converted[TILE * 4];
+	for (size_t i = 0; i < height; ++i)
+	{
+		const unsigned char* row = data + i * stride;
+
+		for (size_t tx = x; tx < x + width; tx = (tx / TILE + 1) * TILE)
+		{
+			size_t count = std::min((tx / TILE + 1) * TILE, x + width) - tx;
+			const unsigned char* tile = tileAt(tx, y + i);
+			convert(row + (tx - x) * data_depth, converted, count, lut);
+			if (memcmp(converted,
+				tile + (((y + i) % TILE) * TILE + tx % TILE) * m_depth,
+				count * m_depth) != 0)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+ftgl::TextureAtlas::Convert ftgl::TextureAtlas::converter(
+	Format format,
+	const unsigned char * lut) const
+{
+	// Order of the first and third bytes of 4 byte atlases, see pixelFormat
+#ifdef GL_UNSIGNED_INT_8_8_8_8_REV
+	const Format stored = Format::BGRA;
+#else
+	const Format stored = Format::RGBA;
+#endif
+
+	Convert convert = nullptr;
+	if (format == Format::Gray)
+	{
+		if (m_depth == 1)
+		{
+			convert = lut ? grayLut : copyPixels<1>;
+		}
+		else
+		{
+			convert = m_depth == 3 ? convert_gray_rgb : convert_gray_rgba;
+		}
+	}
+	else if (m_depth == 3 && formatDepth(format) == 3)
+	{
+		convert = format == Format::RGB ? copyPixels<3> : swap3;
+	}
+	else if (m_depth == 4 && formatDepth(format) == 4)
+	{
+		convert = format == stored ? copyPixels<4> : swap4;
+	}
+	return convert;
+}
+
+void ftgl::TextureAtlas::writeRegion(
+	size_t x,
+	size_t y,
+	size_t width,
+	size_t height,
+	const unsigned char * data,
+	size_t stride,
+	size_t data_depth,
+	Convert convert,
+	const unsigned char * lut)
 {
 	assert(x > 0);
 	assert(y > 0);
@@ -81,193 +327,556 @@ void ftgl::TextureAtlas::setRegion(
 	assert(y < (m_height - 1));
 	assert((y + height) <= (m_height - 1));
 
-	m_dirty = true;
+	std::unique_lock<std::mutex> lock;
+	std::vector<ftgl::ivec4>* dirty = &m_dirty;
+	if (!m_bands.empty())
+	{
+		Band& band = *m_bands[y / m_band_height];
+		// Regions with no rows, e.g. of a space, may start on a band boundary
+		assert(!height || (y + height - 1) / m_band_height == y / m_band_height);
+
+		lock = std::unique_lock<std::mutex>(band.mutex);
+		dirty = &band.dirty;
+	}
 
-	size_t charsize = sizeof(char);
+	markDirty(*dirty, { { int(x), int(y), int(width), int(height) } });
 
 	for (size_t i = 0; i < height; ++i)
 	{
-		memcpy(m_data.get() + ((y + i)*m_width + x) * charsize * m_depth,
-			   data + (i*stride) * charsize, 
-			   width * charsize * m_depth);
+		const unsigned char* row = data + i * stride;
+
+		// Rows are split at tile boundaries
+		for (size_t tx = x; tx < x + width; tx = (tx / TILE + 1) * TILE)
+		{
+			size_t count = std::min((tx / TILE + 1) * TILE, x + width) - tx;
+			unsigned char* tile = tileAt(tx, y + i);
+			convert(row + (tx - x) * data_depth,
+				tile + (((y + i) % TILE) * TILE + tx % TILE) * m_depth,
+				count, lut);
+		}
 	}
 }
 
-
-int ftgl::TextureAtlas::fit(
-	      size_t index,
-	const size_t width,
-	const size_t height)
+void ftgl::TextureAtlas::readRegion(
+	size_t x,
+	size_t y,
+	size_t width,
+	size_t height,
+	unsigned char * data,
+	size_t stride) const
 {
+	assert((x + width) <= m_width);
+	assert((y + height) <= m_height);
 
-	int width_left = width;
-	auto node = m_nodes[index];
-	int x = node.x;
-	int y = node.y;
+	for (size_t i = 0; i < height; ++i)
+	{
+		unsigned char* row = data + i * stride;
 
+		for (size_t tx = x; tx < x + width; tx = (tx / TILE + 1) * TILE)
+		{
+			size_t count = std::min((tx / TILE + 1) * TILE, x + width) - tx;
+			const unsigned char* tile = tileAt(tx, y + i);
+			memcpy(row + (tx - x) * m_depth,
+				tile + (((y + i) % TILE) * TILE + tx % TILE) * m_depth,
+				count * m_depth);
+		}
+	}
+}
 
-	if ((x + width) > (m_width - 1))
+
+ftgl::ivec4 ftgl::TextureAtlas::getRegion(size_t width, size_t height)
+{
+	// Keep an empty texel between regions at the last mipmap level
+	size_t padding = m_mip_levels ? (size_t(2) << m_mip_levels) - 1 : 0;
+
+	ftgl::ivec4 region;
+	if (m_bands.empty())
+	{
+		region = m_skyline.getRegion(width + padding, height + padding);
+	}
+	else
 	{
-		return -1;
+		// Threads start from different bands and only meet once theirs
+		// are full
+		size_t home = std::hash<std::thread::id>()(std::this_thread::get_id());
+		for (size_t i = 0; i < m_bands.size(); ++i)
+		{
+			Band& band = *m_bands[(home + i) % m_bands.size()];
+			std::lock_guard<std::mutex> lock(band.mutex);
+			region = band.skyline.getRegion(width + padding, height + padding);
+			if (region.x >= 0) break;
+		}
 	}
 
-	while (width_left > 0)
+	if (region.x >= 0)
 	{
-		assert(index < m_nodes.size());
+		region.width = int(width);
+		region.height = int(height);
+		m_used += width * height;
+	}
+	return region;
+}
+
 
-		node = m_nodes[index];
-		if (node.y > y)
+void ftgl::TextureAtlas::markDirty(
+	std::vector<ftgl::ivec4>& dirty,
+	const ftgl::ivec4& region)
+{
+	// Merge with any region whose bounding box wastes no more than the two
+	// regions themselves; neighbouring glyphs on a skyline row end up in a
+	// single upload this way. Merging can make the result reach others, so
+	// keep going until nothing changes.
+	// Without a CPU copy of the rest of the atlas, the bounding box must not
+	// cover anything but the two regions.
+	ftgl::ivec4 merged = region;
+	for (size_t i = 0; i < dirty.size();)
+	{
+		auto box = bounds(merged, dirty[i]);
+		int covered = area(merged) + area(dirty[i]);
+		if (m_gpu_resident
+			? (area(box) == covered - overlap(merged, dirty[i]))
+			: (area(box) <= 2 * covered))
 		{
-			y = node.y;
+			merged = box;
+			dirty.erase(dirty.begin() + i);
+			i = 0;
 		}
-		if ((y + height) > (m_height - 1))
+		else
 		{
-			return -1;
+			++i;
 		}
-		width_left -= node.z;
-		++index;
 	}
-	return y;
+	dirty.push_back(merged);
+
+	if (!m_gpu_resident && dirty.size() > MAX_DIRTY_REGIONS)
+	{
+		for (auto&& r : dirty)
+		{
+			merged = bounds(merged, r);
+		}
+		dirty.assign(1, merged);
+	}
 }
 
-void ftgl::TextureAtlas::merge()
+void ftgl::TextureAtlas::clear()
 {
-	for (size_t i = 0; i < m_nodes.size() - 1; ++i)
+	// Every band stays locked until its tiles are gone
+	std::vector<std::unique_lock<std::mutex>> locks;
+	for (auto&& band : m_bands)
 	{
-		auto& node = m_nodes[i];
-		auto& next = m_nodes[i + 1];
+		locks.emplace_back(band->mutex);
+		band->skyline.clear();
+		band->dirty.assign(1, band->rows);
+	}
 
-		if (node.y == next.y)
-		{
-			node.z += next.z;
-			m_nodes.erase(m_nodes.begin() + i + 1);
-			--i;
-		}
+	m_used = 0;
+	if (m_bands.empty())
+	{
+		m_dirty.assign(1, { { 0, 0, int(m_width), int(m_height) } });
 	}
+	
+	m_skyline.clear();
+
+	// Untouched tiles read as zero, no need to keep them around
+	releaseTiles();
 }
 
+void ftgl::TextureAtlas::setStreaming(size_t buffers)
+{
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	if (buffers)
+	{
+		m_staging = std::make_unique<PixelUnpackRing>(buffers);
+	}
+	else
+	{
+		m_staging.reset();
+	}
+#endif
+}
 
-ftgl::ivec4 ftgl::TextureAtlas::getRegion(size_t width, size_t height)
+void ftgl::TextureAtlas::upload()
 {
-	ftgl::ivec4 region = { {0, 0, int(width), int(height)} };
+	std::vector<unsigned char> snapshot;
+	if (!m_bands.empty())
+	{
+		snapshotBands(snapshot);
+	}
+
+	if (m_id && m_dirty.empty()) return;
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-	size_t best_height = std::numeric_limits<size_t>::max();
-	int best_index = -1;
-	size_t best_width = std::numeric_limits<size_t>::max();
-	for (size_t i = 0; i < m_nodes.size(); ++i)
+	if (!m_id)
 	{
-		int y = fit(i, width, height);
-		if (y >= 0)
+		auto pixel = pixelFormat(m_depth);
+
+		glGenTextures(1, &m_id);
+		glBindTexture(GL_TEXTURE_2D, m_id);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+			m_mip_levels ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+#ifdef GL_TEXTURE_MAX_LEVEL
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, GLint(m_mip_levels));
+#endif
+
+		if (m_bands.empty())
 		{
-			auto node = m_nodes[i];
-			if (((y + height) < best_height)
-				|| (((y + height) == best_height)
-					&& (node.z > 0
-						&& size_t(node.z) < best_width)))
+			m_dirty.assign(1, { { 0, 0, int(m_width), int(m_height) } });
+		}
+
+		if (m_compressed)
+		{
+#ifdef GL_COMPRESSED_RED_RGTC1
+			std::vector<unsigned char> blocks(m_width * m_height / 2);
+			compressRegion(0, 0, m_width, m_height, blocks.data());
+			glCompressedTexImage2D(GL_TEXTURE_2D, 0, GL_COMPRESSED_RED_RGTC1,
+				m_width, m_height, 0, GLsizei(blocks.size()), blocks.data());
+#endif
+		}
+		else
+		{
+			// The base level is sent whole with its storage. The snapshot of
+			// the bands holds its rows in order, the tiles are gathered first
+			std::vector<unsigned char> pixels;
+			const unsigned char* data = snapshot.data();
+			if (m_bands.empty())
 			{
-				best_height = y + height;
-				best_index = i;
-				best_width = node.z;
-				region.x = node.x;
-				region.y = y;
+				pixels.resize(m_width * m_height * m_depth);
+				readRegion(0, 0, m_width, m_height, pixels.data(), m_width * m_depth);
+				data = pixels.data();
 			}
+			assert(m_bands.empty() || snapshot.size() == m_width * m_height * m_depth);
+
+			for (size_t level = 0; level <= m_mip_levels; ++level)
+			{
+				glTexImage2D(GL_TEXTURE_2D, GLint(level), pixel.internal_format,
+					m_width >> level, m_height >> level,
+					0, pixel.format, pixel.type, level ? nullptr : data);
+			}
+		}
+	}
+	else
+	{
+		glBindTexture(GL_TEXTURE_2D, m_id);
+
+		if (m_compressed)
+		{
+			uploadCompressed();
+		}
+		else if (!m_bands.empty())
+		{
+			uploadSnapshot(snapshot);
+		}
+		else if (!m_staging || !streamRegions())
+		{
+			uploadRegions();
 		}
 	}
 
-	if (best_index == -1)
+	if (m_mip_levels)
+	{
+		uploadMipmaps();
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	m_dirty.clear();
+
+	if (m_gpu_resident)
 	{
-		region.x = -1;
-		region.y = -1;
-		region.width = 0;
-		region.height = 0;
-		return region;
+		releaseTiles();
 	}
+}
 
-	//new_node.x = region.x;
-	//new_node.y = region.y + height;
-	//new_node.z = width;
-	Node new_node{ region.x, region.y + int(height), int(width) };
+void ftgl::TextureAtlas::setGpuResident(bool resident)
+{
+	assert(!(resident && m_compressed));
+	assert(!(resident && !m_bands.empty()));
 
-	m_nodes.insert(m_nodes.begin() + best_index, new_node);
+	m_gpu_resident = resident;
+}
 
-	for (size_t i = best_index + 1; i < m_nodes.size(); ++i)
+ftgl::Skyline::Nodes ftgl::TextureAtlas::nodes() const
+{
+	if (m_bands.empty())
 	{
-		auto& node = m_nodes[i];
-		auto& prev = m_nodes[i - 1];
+		return m_skyline.nodes();
+	}
 
-		if (node.x >= (prev.x + prev.z)) break;
+	Nodes nodes;
+	for (auto&& band : m_bands)
+	{
+		std::lock_guard<std::mutex> lock(band->mutex);
+		auto band_nodes = band->skyline.nodes();
+		nodes.insert(nodes.end(), band_nodes.begin(), band_nodes.end());
+	}
+	return nodes;
+}
 
-		int shrink = prev.x + prev.z - node.x;
-		node.x += shrink;
-		node.z -= shrink;
+void ftgl::TextureAtlas::setConcurrent(size_t bands)
+{
+	assert(m_used == 0);
+	assert(!bands || !(m_compressed || m_mip_levels || m_gpu_resident));
 
-		if (node.z > 0) break;
+	m_bands.clear();
+	if (!bands) return;
 
-		m_nodes.erase(m_nodes.begin() + i);
-		--i;
+	// Bands hold whole rows of tiles, so tiles never need two locks
+	m_band_height = ((m_height + bands - 1) / bands + TILE - 1) / TILE * TILE;
+	for (size_t top = 0; top < m_height; top += m_band_height)
+	{
+		size_t bottom = std::min(top + m_band_height, m_height);
+		m_bands.push_back(std::make_unique<Band>(m_width,
+			std::max(top, size_t(1)), std::min(bottom, m_height - 1),
+			ftgl::ivec4{ { 0, int(top), int(m_width), int(bottom - top) } }));
 	}
-	merge();
-	m_used += width * height;
-	return region;
 }
 
+void ftgl::TextureAtlas::setMipLevels(size_t levels)
+{
+	assert(m_used == 0);
+	assert(!(levels && !m_bands.empty()));
+	assert(!(levels && m_compressed));
+	assert(m_width % (size_t(1) << levels) == 0);
+	assert(m_height % (size_t(1) << levels) == 0);
 
-void ftgl::TextureAtlas::clear()
+	m_mip_levels = levels;
+}
+
+void ftgl::TextureAtlas::setCompressed(bool compressed)
 {
-	m_used = 0;
-	m_dirty = true;
-	
-	m_nodes.clear();
+#ifdef GL_COMPRESSED_RED_RGTC1
+	assert(!compressed || m_depth == 1);
+	assert(!compressed || (m_width % 4 == 0 && m_height % 4 == 0));
+	assert(!(compressed && m_gpu_resident));
+	assert(!(compressed && m_mip_levels));
+	assert(!(compressed && !m_bands.empty()));
+
+	m_compressed = compressed;
+#endif
+}
 
-	// We want a one pixel border around the whole atlas to avoid any artefact when
-	// sampling texture
-	m_nodes.push_back(Node{ 1, 1, int(m_width) - 2 });
+void ftgl::TextureAtlas::compressRegion(
+	size_t x,
+	size_t y,
+	size_t width,
+	size_t height,
+	unsigned char * blocks) const
+{
+	assert(m_depth == 1);
+	assert(x % 4 == 0 && y % 4 == 0 && width % 4 == 0 && height % 4 == 0);
+	assert((x + width) <= m_width);
+	assert((y + height) <= m_height);
 
-	// Clear out the data
-	memset(m_data.get(), 0, m_width*m_height*m_depth);
+	// Tiles hold whole blocks, which are encoded straight from them
+	for (size_t by = y; by < y + height; by += 4)
+	{
+		for (size_t bx = x; bx < x + width; bx += 4)
+		{
+			bc4_encode_block(tileAt(bx, by) + (by % TILE) * TILE + bx % TILE,
+				TILE, blocks);
+			blocks += BC4_BLOCK_SIZE;
+		}
+	}
 }
 
-void ftgl::TextureAtlas::upload()
+void ftgl::TextureAtlas::invalidate()
 {
-	if (!m_dirty) return;
+	// The GL objects died with the context, forget them without deleting
+	m_id = 0;
+	if (m_staging)
+	{
+		m_staging->abandon();
+	}
+}
 
-	if (!m_id)
+void ftgl::TextureAtlas::releaseTiles()
+{
+	for (auto&& tile : m_tiles)
 	{
-		glGenTextures(1, &m_id);
+		tile.reset();
 	}
+}
+
+void ftgl::TextureAtlas::uploadRegions()
+{
+	auto pixel = pixelFormat(m_depth);
 
-	glBindTexture(GL_TEXTURE_2D, m_id);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+#ifdef GL_UNPACK_ROW_LENGTH
+	// Each region is sent tile by tile, straight from the tile data
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, TILE);
 
-	if (m_depth == 4)
+	for (auto&& r : m_dirty)
 	{
-#ifdef GL_UNSIGNED_INT_8_8_8_8_REV
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height,
-			0, GL_BGRA, GL_UNSIGNED_INT_8_8_8_8_REV, data());
+		size_t right = r.x + r.width;
+		size_t bottom = r.y + r.height;
+
+		for (size_t y = r.y; y < bottom; y = (y / TILE + 1) * TILE)
+		{
+			size_t height = std::min((y / TILE + 1) * TILE, bottom) - y;
+
+			for (size_t x = r.x; x < right; x = (x / TILE + 1) * TILE)
+			{
+				size_t width = std::min((x / TILE + 1) * TILE, right) - x;
+
+				glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+					pixel.format, pixel.type,
+					tileAt(x, y) + ((y % TILE) * TILE + x % TILE) * m_depth);
+			}
+		}
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 #else
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_width, m_height,
-			0, GL_RGBA, GL_UNSIGNED_BYTE, data());
+	// Without GL_UNPACK_ROW_LENGTH (GLES2) regions are gathered first
+	std::vector<unsigned char> pixels;
+
+	for (auto&& r : m_dirty)
+	{
+		pixels.resize(r.width * r.height * m_depth);
+		readRegion(r.x, r.y, r.width, r.height,
+			pixels.data(), r.width * m_depth);
+
+		glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.width, r.height,
+			pixel.format, pixel.type, pixels.data());
+	}
 #endif
+}
+
+void ftgl::TextureAtlas::snapshotBands(std::vector<unsigned char>& pixels)
+{
+	for (auto&& band : m_bands)
+	{
+		std::lock_guard<std::mutex> lock(band->mutex);
+
+		// A new texture needs every band
+		if (!m_id)
+		{
+			band->dirty.assign(1, band->rows);
+		}
+
+		for (auto&& r : band->dirty)
+		{
+			size_t offset = pixels.size();
+			pixels.resize(offset + area(r) * m_depth);
+			readRegion(r.x, r.y, r.width, r.height, &pixels[offset], r.width * m_depth);
+			m_dirty.push_back(r);
+		}
+		band->dirty.clear();
 	}
-	else if (m_depth == 3)
+}
+
+void ftgl::TextureAtlas::uploadSnapshot(const std::vector<unsigned char>& pixels)
+{
+	auto pixel = pixelFormat(m_depth);
+
+	size_t offset = 0;
+	for (auto&& r : m_dirty)
 	{
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, m_width, m_height,
-			0, GL_RGB, GL_UNSIGNED_BYTE, data());
+		glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.width, r.height,
+			pixel.format, pixel.type, &pixels[offset]);
+		offset += area(r) * m_depth;
 	}
-	else
+}
+
+void ftgl::TextureAtlas::uploadMipmaps()
+{
+	auto pixel = pixelFormat(m_depth);
+	size_t block = size_t(1) << m_mip_levels;
+	std::vector<unsigned char> pixels;
+
+	for (auto&& r : m_dirty)
 	{
-#if defined(GL_ES_VERSION_2_0) || defined(GL_ES_VERSION_3_0)
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE, m_width, m_height,
-			0, GL_LUMINANCE, GL_UNSIGNED_BYTE, data());
-#else
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, m_width, m_height,
-			0, GL_RED, GL_UNSIGNED_BYTE, data());
-#endif
+		// Every texel of the chain covering the region comes from the
+		// aligned blocks around it, which padding keeps to this region.
+		size_t x = r.x & ~(block - 1);
+		size_t y = r.y & ~(block - 1);
+		size_t width = ((r.x + r.width + block - 1) & ~(block - 1)) - x;
+		size_t height = ((r.y + r.height + block - 1) & ~(block - 1)) - y;
+
+		pixels.resize(width * height * m_depth);
+		readRegion(x, y, width, height, pixels.data(), width * m_depth);
+
+		// Reduced in place, one level after the other
+		for (size_t level = 1; level <= m_mip_levels; ++level)
+		{
+			width /= 2;
+			height /= 2;
+			mipmap_downsample(pixels.data(), 2 * width * m_depth,
+				pixels.data(), width * m_depth, width, height, m_depth);
+
+			glTexSubImage2D(GL_TEXTURE_2D, GLint(level), x >> level, y >> level,
+				width, height, pixel.format, pixel.type, pixels.data());
+		}
 	}
+}
 
-	m_dirty = false;
+void ftgl::TextureAtlas::uploadCompressed()
+{
+#ifdef GL_COMPRESSED_RED_RGTC1
+	std::vector<unsigned char> blocks;
+
+	for (auto&& r : m_dirty)
+	{
+		// Grow the region to whole blocks
+		size_t x = r.x & ~3;
+		size_t y = r.y & ~3;
+		size_t width = ((r.x + r.width + 3) & ~3) - x;
+		size_t height = ((r.y + r.height + 3) & ~3) - y;
+
+		blocks.resize(width * height / 2);
+		compressRegion(x, y, width, height, blocks.data());
+
+		glCompressedTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height,
+			GL_COMPRESSED_RED_RGTC1, GLsizei(blocks.size()), blocks.data());
+	}
+#endif
 }
 
+bool ftgl::TextureAtlas::streamRegions()
+{
+#ifdef GL_PIXEL_UNPACK_BUFFER
+	auto pixel = pixelFormat(m_depth);
+
+	size_t size = 0;
+	for (auto&& r : m_dirty)
+	{
+		size += r.width * r.height * m_depth;
+	}
+
+	unsigned char* staging = m_staging->map(size);
+	if (!staging)
+	{
+		return false;
+	}
+
+	// Regions are packed one after the other, rows tightly
+	size_t offset = 0;
+	for (auto&& r : m_dirty)
+	{
+		readRegion(r.x, r.y, r.width, r.height,
+			staging + offset, r.width * m_depth);
+		offset += r.width * r.height * m_depth;
+	}
+	if (!m_staging->unmap())
+	{
+		// The staged pixels are corrupted, the caller uploads them directly
+		return false;
+	}
+
+	offset = 0;
+	for (auto&& r : m_dirty)
+	{
+		glTexSubImage2D(GL_TEXTURE_2D, 0, r.x, r.y, r.width, r.height,
+			pixel.format, pixel.type, reinterpret_cast<const void*>(offset));
+		offset += r.width * r.height * m_depth;
+	}
+	m_staging->fence();
+
+	return true;
+#else
+	return false;
+#endif
+}
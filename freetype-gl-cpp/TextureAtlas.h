@@ -46,12 +46,15 @@
 #include <cstdlib>
 #include <vector>
 #include "vec234.h"
+#include "Skyline.h"
+#include <atomic>
 #include <memory>
 
 //#include "vector.h"
 
 namespace ftgl {
 
+class PixelUnpackRing;
 
 /**
  * @file   texture-atlas.h
@@ -93,13 +96,13 @@ namespace ftgl {
 
 class TextureAtlas
 {
-	using Node = ftgl::ivec3;
-	using Nodes = std::vector<Node>;
+	using Node = Skyline::Node;
+	using Nodes = Skyline::Nodes;
 private:
 	/**
-	* Allocated nodes
+	* Skyline of allocated regions
 	*/
-	Nodes m_nodes;
+	Skyline m_skyline;
 
 	/**
 	*  Width (in pixels) of the underlying texture
@@ -119,7 +122,7 @@ private:
 	/**
 	* Allocated surface size
 	*/
-	size_t m_used;
+	std::atomic<size_t> m_used;
 
 	/**
 	* Texture identity (OpenGL)
@@ -127,16 +130,72 @@ private:
 	unsigned int m_id;
 
 	/**
-	* Atlas data. unique_ptr with custom deleter (free)
+	* Atlas data, split in TILE_SIZE x TILE_SIZE tiles stored row by row.
+	* Tiles are allocated the first time setRegion touches them, null tiles
+	* read as zero.
 	*/
-	std::unique_ptr<unsigned char, decltype(std::free)*> m_data;
+	std::vector<std::unique_ptr<unsigned char[]>> m_tiles;
 
 	/**
-	* the texture is dirty and needs reuploading
+	* Number of tiles per row
 	*/
-	bool m_dirty = true;
+	size_t m_tiles_x;
+
+	/**
+	* Regions modified since the last upload, coalesced by setRegion
+	*/
+	std::vector<ftgl::ivec4> m_dirty;
+
+	/**
+	* Staging buffers used when streaming uploads, null for direct uploads
+	*/
+	std::unique_ptr<PixelUnpackRing> m_staging;
+
+	/**
+	* Drop the data once it has been uploaded
+	*/
+	bool m_gpu_resident = false;
+
+	/**
+	* Store the texture as BC4 blocks
+	*/
+	bool m_compressed = false;
+
+	/**
+	* Number of mipmap levels generated below the base level
+	*/
+	size_t m_mip_levels = 0;
+
+	/**
+	* Horizontal bands packed and written independently in concurrent mode,
+	* empty otherwise
+	*/
+	struct Band;
+	std::vector<std::unique_ptr<Band>> m_bands;
+
+	/**
+	* Height (in pixels) of the bands, a multiple of TILE_SIZE
+	*/
+	size_t m_band_height = 0;
 
 public:
+	/**
+	* Side (in pixels) of the tiles backing the atlas data
+	*/
+	static constexpr size_t TILE_SIZE = 64;
+
+	/**
+	* Layout of the pixels given to setRegion
+	*/
+	enum class Format
+	{
+		Gray,
+		RGB,
+		BGR,
+		RGBA,
+		BGRA
+	};
+
 	TextureAtlas(size_t width, size_t height, size_t depth);
 	~TextureAtlas();
 
@@ -148,15 +207,107 @@ public:
 	size_t height() const { return m_height; }
 	size_t depth() const { return m_depth; }
 	unsigned id() const { return m_id; }
-	const void* data() const { return m_data.get(); }
-	const Nodes& nodes() const { return m_nodes; }
-	Nodes& nodes() { return m_nodes; }
+
+	/**
+	*  Bytes of system memory currently held by the atlas data.
+	*/
+	size_t allocated() const;
+	Nodes nodes() const;
 
 	/**
 	*  Upload atlas to video memory.
+	*
+	*  The texture is created with the whole atlas on the first call, later
+	*  calls only send the regions modified since the previous upload.
 	*/
 	void upload();
 
+	/**
+	*  Stream uploads through a ring of pixel unpack buffers.
+	*
+	*  Dirty regions are staged into the next buffer of the ring and the
+	*  texture is updated from it, so upload() does not wait for the driver
+	*  to copy the pixels. Two or three buffers are usually enough.
+	*
+	*  @param buffers number of staging buffers, 0 to upload directly
+	*/
+	void setStreaming(size_t buffers);
+
+	/**
+	*  Keep the atlas data on the GPU only.
+	*
+	*  The tiles are released after every upload, only the regions set since
+	*  the previous upload are held in system memory. Dirty regions are then
+	*  never merged beyond their exact union, and readRegion() returns zeros
+	*  for anything already uploaded. After a context loss the content has
+	*  to be regenerated, see Font::restore().
+	*/
+	void setGpuResident(bool resident);
+	bool gpuResident() const { return m_gpu_resident; }
+
+	/**
+	*  Store the texture as BC4/RGTC1 blocks, halving its video memory.
+	*
+	*  Only for single channel atlases whose size is a multiple of 4. On
+	*  upload, the 4x4 blocks covered by dirty regions are encoded on the CPU
+	*  and sent with glCompressedTexSubImage2D; streaming is not used for
+	*  them. Not available in GPU resident mode, since encoding a block
+	*  needs all of its pixels. Takes effect when the texture is created.
+	*/
+	void setCompressed(bool compressed);
+	bool compressed() const { return m_compressed; }
+
+	/**
+	*  Generate mipmaps on the CPU so minified text stays clean.
+	*
+	*  Regions get padded so that no 2^levels aligned block of pixels, nor
+	*  its bilinear neighbourhood at the last level, holds two of them. On
+	*  upload, only the mip texels covering dirty regions are regenerated
+	*  with a 2x2 box filter and sent. Must be set before the first region
+	*  is allocated; not available for compressed atlases.
+	*
+	*  @param levels number of levels below the base one, 0 to disable
+	*/
+	void setMipLevels(size_t levels);
+	size_t mipLevels() const { return m_mip_levels; }
+
+	/**
+	*  Encode the 4x4 blocks covering a region as BC4, one row of blocks
+	*  after the other.
+	*
+	*  @param x      x coordinate the region, multiple of 4
+	*  @param y      y coordinate the region, multiple of 4
+	*  @param width  width of the region, multiple of 4
+	*  @param height height of the region, multiple of 4
+	*  @param blocks destination of width * height / 2 bytes
+	*/
+	void compressRegion(size_t x, size_t y, size_t width, size_t height,
+		unsigned char* blocks) const;
+
+	/**
+	*  Let several threads allocate and write regions at the same time.
+	*
+	*  The atlas is split into horizontal bands of whole tiles, each with its
+	*  own skyline, dirty regions and lock. getRegion starts from a band
+	*  picked by the calling thread and moves on to the next ones when it is
+	*  full; setRegion locks the band holding the region, which must not
+	*  cross bands. upload() copies the dirty regions of each band under its
+	*  lock and sends the copies afterwards, so it only has to run on the GL
+	*  thread. Streaming, mipmaps, compression and GPU resident mode are not
+	*  available in this mode. Must be set before the first region is
+	*  allocated.
+	*
+	*  @param bands number of bands, 0 to go back to a single skyline
+	*/
+	void setConcurrent(size_t bands);
+	bool concurrent() const { return !m_bands.empty(); }
+
+	/**
+	*  Forget the texture after the GL context was lost. The next upload()
+	*  creates a new one from the data held in system memory.
+	*/
+	void invalidate();
+
 	/**
 	*  Allocate a new region in the atlas.
 	*
@@ -174,21 +325,92 @@ public:
 	*  @param y      y coordinate the region
 	*  @param width  width of the region
 	*  @param m_height m_height of the region
-	*  @param data   data to be uploaded into the specified region
-	*  @param stride stride of the data
+	*  @param data   data to be uploaded into the specified region, in the
+	*                layout the atlas stores
+	*  @param stride stride of the data, in bytes
 	*
 	*/
 	void setRegion(size_t x, size_t y, size_t width, size_t height,
 		const unsigned char* data, size_t stride);
 
 	/**
-	*  Remove all allocated regions from the atlas.
+	*  Convert data to the atlas layout and upload it to the specified region.
+	*
+	*  Gray data goes to any depth, as premultiplied white in RGBA atlases,
+	*  and may be mapped through a lookup table on the way. RGB and BGR data
+	*  go to 3 byte atlases, RGBA and BGRA data to 4 byte ones.
+	*
+	*  @param x      x coordinate the region
+	*  @param y      y coordinate the region
+	*  @param width  width of the region
+	*  @param height height of the region
+	*  @param data   data to be uploaded into the specified region
+	*  @param stride stride of the data, in bytes
+	*  @param format layout of the data
+	*  @param lut    256 entry table applied to gray data, or null
+	*
+	*  @return false, writing nothing, if the atlas cannot store the format
+	*/
+	bool setRegion(size_t x, size_t y, size_t width, size_t height,
+		const unsigned char* data, size_t stride,
+		Format format, const unsigned char* lut = nullptr);
+
+	/**
+	*  Whether the specified atlas region holds data, once converted as
+	*  setRegion() would. Regions already uploaded by a GPU resident atlas
+	*  read as zeros.
+	*
+	*  @param x      x coordinate the region
+	*  @param y      y coordinate the region
+	*  @param width  width of the region
+	*  @param height height of the region
+	*  @param data   data to compare the region with
+	*  @param stride stride of the data, in bytes
+	*  @param format layout of the data
+	*  @param lut    256 entry table applied to gray data, or null
+	*
+	*/
+	bool matchRegion(size_t x, size_t y, size_t width, size_t height,
+		const unsigned char* data, size_t stride,
+		Format format, const unsigned char* lut = nullptr) const;
+
+	/**
+	*  Copy the data of the specified atlas region.
+	*
+	*  @param x      x coordinate the region
+	*  @param y      y coordinate the region
+	*  @param width  width of the region
+	*  @param height height of the region
+	*  @param data   destination of the region data
+	*  @param stride stride of the destination
+	*
+	*/
+	void readRegion(size_t x, size_t y, size_t width, size_t height,
+		unsigned char* data, size_t stride) const;
+
+	/**
+	*  Remove all allocated regions from the atlas and release its data.
 	*/
 	void clear();
 
 private:
-	int fit(size_t index, size_t width, size_t height);
-	void merge();
+	using Convert = void(*)(const unsigned char* src, unsigned char* dst,
+		size_t count, const unsigned char* lut);
+
+	void writeRegion(size_t x, size_t y, size_t width, size_t height,
+		const unsigned char* data, size_t stride, size_t data_depth,
+		Convert convert, const unsigned char* lut);
+	Convert converter(Format format, const unsigned char* lut) const;
+	void markDirty(std::vector<ftgl::ivec4>& dirty, const ftgl::ivec4& region);
+	void snapshotBands(std::vector<unsigned char>& pixels);
+	void uploadSnapshot(const std::vector<unsigned char>& pixels);
+	void uploadRegions();
+	bool streamRegions();
+	void uploadCompressed();
+	void uploadMipmaps();
+	void releaseTiles();
+	unsigned char* tileAt(size_t x, size_t y);
+	const unsigned char* tileAt(size_t x, size_t y) const;
 };
 
 }// namespace ftgl
\ No newline at end of file
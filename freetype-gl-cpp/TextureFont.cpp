@@ -38,8 +38,11 @@
 #include FT_LCD_FILTER_H
 
 #include <cstdint>
+#include <cstring>
 #include <cassert>
+#include <cmath>
 #include <algorithm>
+#include <chrono>
 
 #include "utf8Utils.h"
 #include "TextureFont.h"
@@ -54,6 +57,82 @@ static constexpr int   DPI   = 72;
 #include "FT_Errors.h"
 #endif
 
+/* Pixels of the special background glyph, any atlas depth */
+static constexpr unsigned char BACKGROUND_DATA[4 * 4 * 4]{
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255 };
+
+/* LCD bitmaps fill RGB atlases, gray coverage goes to the other depths */
+static ftgl::TextureAtlas::Format bitmapFormat(size_t depth)
+{
+	return depth == 3 ? ftgl::TextureAtlas::Format::RGB
+		: ftgl::TextureAtlas::Format::Gray;
+}
+
+/* A rasterized glyph, owning the outline glyph it may come from */
+struct ftgl::Font::Bitmap
+{
+	FT_Bitmap bitmap;
+	int left = 0;
+	int top = 0;
+	FT_Glyph glyph = nullptr;
+
+	~Bitmap()
+	{
+		if (glyph)
+		{
+			FT_Done_Glyph(glyph);
+		}
+	}
+};
+
+/* 64 bit hash of the size and pixels of a bitmap, eight bytes at a time */
+static uint64_t hashBitmap(const FT_Bitmap& bitmap)
+{
+	const uint64_t PRIME = 0x100000001b3ull;
+	uint64_t hash = 0xcbf29ce484222325ull;
+	hash = (hash ^ bitmap.width) * PRIME;
+	hash = (hash ^ bitmap.rows) * PRIME;
+
+	for (unsigned row = 0; row < bitmap.rows; ++row)
+	{
+		const unsigned char* data = bitmap.buffer + ptrdiff_t(row) * bitmap.pitch;
+		size_t i = 0;
+		for (; i + 8 <= bitmap.width; i += 8)
+		{
+			uint64_t word;
+			memcpy(&word, data + i, 8);
+			hash = (hash ^ word) * PRIME;
+			hash ^= hash >> 29;
+		}
+		for (; i < bitmap.width; ++i)
+		{
+			hash = (hash ^ data[i]) * PRIME;
+		}
+	}
+
+	hash ^= hash >> 32;
+	hash *= 0xd6e8feb86659fd93ull;
+	return hash ^ (hash >> 32);
+}
+
+/* Progress of the codepoints queued by one prewarm() call */
+struct ftgl::Font::Job
+{
+	std::promise<size_t> done;
+	size_t remaining = 0;
+	size_t missed = 0;
+};
+
+/* Heap order of the pending codepoints: highest priority, then oldest */
+bool ftgl::Font::later(const Pending& a, const Pending& b)
+{
+	return a.priority < b.priority
+		|| (a.priority == b.priority && a.order > b.order);
+}
+
 
 float ftgl::Glyph::getKerning(const char * codepoint) const
 {
@@ -62,13 +141,18 @@ float ftgl::Glyph::getKerning(const char * codepoint) const
 
 float ftgl::Glyph::getKerning(uint32_t ucodepoint) const
 {
-	auto k_it = std::find_if(kernings.begin(), kernings.end(),
+	// The loader may be replacing the list, take the current one
+	auto list = std::atomic_load(&kernings);
+	if (!list)
+		return 0;
+
+	auto k_it = std::find_if(list->begin(), list->end(),
 		[ucodepoint](const Kerning& kerning)
 	{
 		return kerning.codepoint == ucodepoint;
 	});
 
-	if (k_it != kernings.end())
+	if (k_it != list->end())
 		return k_it->kerning;
 
 	return 0;
@@ -81,6 +165,7 @@ ftgl::Font::Font(TextureAtlas* atlas, float pt_size, File file) :
 	m_atlas(atlas),
 	m_location(TEXTURE_FONT_FILE),
 	m_filename(file.filename),
+	m_file(FontFile::open(file.filename)),
 	m_size(pt_size)
 {
 	m_success = init();
@@ -99,21 +184,71 @@ ftgl::Font::Font(TextureAtlas* atlas, float pt_size, Memory memory) :
 	m_success = init();
 }
 
-bool ftgl::Font::init()
+
+ftgl::Font::Font(TextureAtlas* atlas, float pt_size,
+	std::shared_ptr<FontFile> file) :
+	m_atlas(atlas),
+	m_location(TEXTURE_FONT_MEMORY),
+	m_memory{ file ? file->data() : nullptr, file ? file->size() : 0 },
+	m_file(std::move(file)),
+	m_size(pt_size)
+{
+	assert(m_file);
+
+	m_success = init();
+}
+
+ftgl::Font::~Font()
 {
-	FT_Library library;
-	FT_Face face;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_stop = true;
+	}
+	m_wake.notify_all();
+
+	if (m_worker.joinable())
+	{
+		m_worker.join();
+	}
 
+	// Codepoints the worker never got to count as missed
+	for (auto&& pending : m_pending)
+	{
+		finish(pending, true);
+	}
+}
+
+bool ftgl::Font::init()
+{
 	assert(m_size > 0);
 	assert((m_location == TEXTURE_FONT_FILE && 
 		    m_filename.generic_string().size())
 		|| (m_location == TEXTURE_FONT_MEMORY
 			&& m_memory.base && m_memory.size));
 
+	/* Share the face of any other font of the same source */
+	if (m_file)
+	{
+		m_face = FaceCache::open(m_file, 0);
+	}
+	else if (m_location == TEXTURE_FONT_FILE)
+	{
+		m_face = FaceCache::open(m_filename.generic_string(), 0);
+	}
+	else
+	{
+		m_face = FaceCache::open(m_memory.base, m_memory.size, 0);
+	}
 
-	if (!loadFace(m_size * 100.f, &library, &face))
+	if (!m_face)
 		return false;
 
+	auto lease = loadFace(m_size * 100.f);
+	if (!lease)
+		return false;
+
+	FT_Face face = lease.face();
+
 	m_underline_position = face->underline_position / (float)(HRESf*HRESf) * m_size;
 	m_underline_position = round(m_underline_position);
 
@@ -134,8 +269,7 @@ bool ftgl::Font::init()
 	m_descender = (metrics.descender >> 6) / 100.0f;
 	m_height = (metrics.height >> 6) / 100.0f;
 	m_linegap = m_height - m_ascender + m_descender;
-	FT_Done_Face(face);
-	FT_Done_FreeType(library);
+	lease = FaceCache::Lease();
 
 	/* NULL is a special glyph */
 	getGlyph(nullptr);
@@ -149,8 +283,6 @@ ftgl::Font::getGlyph(const char* codepoint)
 	uint32_t ucodepoint = ftgl::utf8_to_utf32(codepoint);
 	Glyph* glyph = nullptr;
 
-	assert(m_filename.generic_string().size());
-
 	/* Check if codepoint has been already loaded */
 	if ((glyph = findGlyph(ucodepoint)))
 		return glyph;
@@ -164,11 +296,6 @@ ftgl::Font::getGlyph(const char* codepoint)
 		size_t height = m_atlas->height();
 		ivec4 region = m_atlas->getRegion(5, 5);
 		Glyph new_glyph;
-		static constexpr unsigned char data[4 * 4 * 3]{
-			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
-			-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1 };
 
 		if (region.x < 0)
 		{
@@ -177,13 +304,15 @@ ftgl::Font::getGlyph(const char* codepoint)
 		#endif
 			return nullptr;
 		}
-		m_atlas->setRegion(region.x, region.y, 4, 4, data, 0);
+		m_atlas->setRegion(region.x, region.y, 4, 4, BACKGROUND_DATA, 0);
 		new_glyph.codepoint = -1;
 		new_glyph.s0 = (region.x + 2) / (float)width;
 		new_glyph.t0 = (region.y + 2) / (float)height;
 		new_glyph.s1 = (region.x + 3) / (float)width;
 		new_glyph.t1 = (region.y + 3) / (float)height;
-		m_glyphs.push_back(new_glyph);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		publish(new_glyph);
 		return &m_glyphs.back();
 	}
 
@@ -200,33 +329,58 @@ const ftgl::Glyph* ftgl::Font::getLoadedGlyph(uint32_t ucodepoint)
 	return findGlyph(ucodepoint);
 }
 
-size_t ftgl::Font::loadGlyphs(const char* codepoints)
+size_t ftgl::Font::getMetrics(const char* text, std::vector<GlyphMetrics>& metrics)
 {
-	assert(codepoints);
+	assert(text);
 
+	size_t missed = 0;
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (size_t length; *text; text += length)
+	{
+		length = utf8_surrogate_len(text);
+		uint32_t ucodepoint = utf8_to_utf32(text);
 
-	FT_Library library;
-	FT_Face face;
-	FT_Glyph ft_glyph = nullptr;
-	FT_GlyphSlot slot;
-	FT_Bitmap ft_bitmap;
+		size_t index = findIndex(ucodepoint, m_outline_type, m_outline_thickness);
+		if (index == m_glyphs.size())
+		{
+			// Loading takes the lock itself
+			std::string codepoint(text, length);
+			lock.unlock();
+			loadGlyphs(codepoint.c_str());
+			lock.lock();
+
+			index = findIndex(ucodepoint, m_outline_type, m_outline_thickness);
+			if (index == m_glyphs.size())
+			{
+				++missed;
+				continue;
+			}
+		}
+		metrics.push_back(m_metrics[index]);
+	}
+	return missed;
+}
 
-	FT_UInt glyph_index;
-	FT_Int32 flags = 0;
-	int ft_glyph_top = 0;
-	int ft_glyph_left = 0;
+const ftgl::Glyph* ftgl::Font::getGlyphAt(size_t index) const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return index < m_glyphs.size() ? &m_glyphs[index] : nullptr;
+}
 
-	ivec4 region;
-	size_t missed = 0;
+size_t ftgl::Font::loadGlyphs(const char* codepoints)
+{
+	assert(codepoints);
 
 
-	auto width = m_atlas->width();
-	auto height = m_atlas->height();
-	auto depth = m_atlas->depth();
+	size_t missed = 0;
 
-	if (!loadFace(m_size, &library, &face))
+	auto lease = loadFace(m_size);
+	if (!lease)
 		return utf8_strlen(codepoints);
 
+	FT_Library library = lease.library();
+	FT_Face face = lease.face();
+
 	/* Load each glyph */
 	for (size_t i = 0; i < utf8_strlen(codepoints); i += utf8_surrogate_len(codepoints + i)) {
 		uint32_t ucodepoint = utf8_to_utf32(codepoints + i);
@@ -234,346 +388,783 @@ size_t ftgl::Font::loadGlyphs(const char* codepoints)
 		if (findGlyph(ucodepoint))
 			continue;
 
-		flags = 0;
-		ft_glyph_top = 0;
-		ft_glyph_left = 0;
-		glyph_index = FT_Get_Char_Index(face, (FT_ULong)utf8_to_utf32(codepoints + i));
-		// WARNING: We use texture-atlas depth to guess if user wants
-		//          LCD subpixel rendering
+		Load load = loadGlyph(library, face, ucodepoint,
+			m_outline_type, m_outline_thickness);
+		if (load == Load::FAILED)
+		{
+			return utf8_strlen(codepoints) - utf8_strlen(codepoints + i);
+		}
+		else if (load == Load::ATLAS_FULL)
+		{
+			missed++;
+		}
+	}
+
+	// Kerning takes the face again
+	lease = FaceCache::Lease();
+	kernGlyphs(std::chrono::steady_clock::time_point::max(), false);
+
+	return missed;
+}
+
+ftgl::Font::Load ftgl::Font::loadGlyph(
+	FT_Library library,
+	FT_Face face,
+	uint32_t ucodepoint,
+	Glyph::Outline outline,
+	float thickness)
+{
+	auto width = m_atlas->width();
+	auto height = m_atlas->height();
+	auto depth = m_atlas->depth();
 
+	Bitmap bitmap;
+	if (!rasterize(library, face, ucodepoint, outline, thickness, bitmap))
+	{
+		return Load::FAILED;
+	}
 
-		if (unsigned char(m_outline_type) > 0)
+	// We want each glyph to be separated by at least one black pixel
+	size_t w = bitmap.bitmap.width / (depth == 3 ? 3 : 1);
+	size_t h = bitmap.bitmap.rows;
+
+	// Glyphs rasterized to the same pixels share their region, the hash
+	// only picks the candidates. A GPU resident atlas no longer holds the
+	// pixels to compare with, so it trusts the 64 bit hash and size
+	auto start = std::chrono::steady_clock::now();
+	uint64_t hash = hashBitmap(bitmap.bitmap);
+	bool compare = !m_atlas->gpuResident();
+	ivec4 region = { { -1, -1, 0, 0 } };
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto candidates = m_regions.equal_range(hash);
+		for (auto it = candidates.first; it != candidates.second; ++it)
 		{
-			flags |= FT_LOAD_NO_BITMAP;
+			const SharedRegion& candidate = it->second;
+			if (candidate.width == bitmap.bitmap.width
+				&& candidate.rows == bitmap.bitmap.rows
+				&& (!compare || m_atlas->matchRegion(candidate.region.x,
+					candidate.region.y, w, h, bitmap.bitmap.buffer,
+					bitmap.bitmap.pitch, bitmapFormat(depth))))
+			{
+				region = candidate.region;
+				break;
+			}
 		}
-		else
+		m_stats.hash_us += uint64_t(std::chrono::duration_cast<
+			std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+	}
+
+	bool shared = region.x >= 0;
+	if (!shared)
+	{
+		region = m_atlas->getRegion(w + 1, h + 1);
+		if (region.x < 0)
 		{
-			flags |= FT_LOAD_RENDER;
+		#ifdef FTGL_STDERR_DISPLAY
+			fprintf(stderr, "Texture atlas is full (line %d)\n", __LINE__);
+		#endif
+
+			return Load::ATLAS_FULL;
 		}
+		m_atlas->setRegion(region.x, region.y, w, h, bitmap.bitmap.buffer,
+			bitmap.bitmap.pitch, bitmapFormat(depth));
+	}
+
+	size_t x = region.x;
+	size_t y = region.y;
+
+	Glyph glyph;
+	glyph.codepoint = ucodepoint;
+	glyph.width = w;
+	glyph.height = h;
+	glyph.outline_type = outline;
+	glyph.outline_thickness = thickness;
+	glyph.offset_x = bitmap.left;
+	glyph.offset_y = bitmap.top;
+	glyph.s0 = x / float(width);
+	glyph.t0 = y / float(height);
+	glyph.s1 = (x + glyph.width) / float(width);
+	glyph.t1 = (y + glyph.height) / float(height);
+
+	// Discard hinting to get advance
+	FT_Load_Glyph(face, FT_Get_Char_Index(face, ucodepoint),
+		FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
+	FT_GlyphSlot slot = face->glyph;
+	glyph.advance_x = slot->advance.x / HRESf;
+	glyph.advance_y = slot->advance.y / HRESf;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (!shared)
+	{
+		m_regions.emplace(hash, SharedRegion{ region, bitmap.bitmap.width,
+			bitmap.bitmap.rows });
+	}
+
+	// Another thread may have loaded the same glyph meanwhile, e.g. the
+	// worker and pumpPending() taking the codepoint from two requests
+	if (findGlyph(ucodepoint, outline, thickness))
+	{
+		return Load::ALREADY_LOADED;
+	}
 
-		if (!m_hinting)
+	if (shared)
+	{
+		m_stats.shared++;
+		m_stats.shared_pixels += (w + 1) * (h + 1);
+	}
+	publish(std::move(glyph));
+	return Load::LOADED;
+}
+
+size_t ftgl::Font::restore()
+{
+	auto width = m_atlas->width();
+	auto height = m_atlas->height();
+
+	auto lease = loadFace(m_size);
+	if (!lease)
+		return m_glyphs.size();
+
+	FT_Library library = lease.library();
+	FT_Face face = lease.face();
+
+	size_t missed = 0;
+	std::lock_guard<std::mutex> lock(m_mutex);
+	for (auto&& glyph : m_glyphs)
+	{
+		size_t x = size_t(std::lround(glyph.s0 * width));
+		size_t y = size_t(std::lround(glyph.t0 * height));
+
+		/* The special glyph only samples the middle of its region */
+		if (glyph.codepoint == uint32_t(-1))
 		{
-			flags |= FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT;
+			m_atlas->setRegion(x - 2, y - 2, 4, 4, BACKGROUND_DATA, 0);
+			continue;
 		}
-		else
+
+		Bitmap bitmap;
+		if (!rasterize(library, face, glyph.codepoint,
+			glyph.outline_type, glyph.outline_thickness, bitmap))
 		{
-			flags |= FT_LOAD_FORCE_AUTOHINT;
+			missed++;
+			continue;
 		}
+		m_atlas->setRegion(x, y, glyph.width, glyph.height,
+			bitmap.bitmap.buffer, bitmap.bitmap.pitch,
+			bitmapFormat(m_atlas->depth()));
+	}
 
-		if (depth == 3)
-		{
-			FT_Library_SetLcdFilter(library, FT_LCD_FILTER_LIGHT);
-			flags |= FT_LOAD_TARGET_LCD;
+	return missed;
+}
 
-			if (m_filtering)
-			{
-				FT_Library_SetLcdFilterWeights(library, m_lcd_weights);
-			}
+std::future<size_t> ftgl::Font::prewarm(
+	const std::vector<Range>& ranges,
+	int priority)
+{
+	std::vector<uint32_t> codepoints;
+	for (auto&& range : ranges)
+	{
+		for (uint32_t c = range.first; c <= range.last && c >= range.first; ++c)
+		{
+			codepoints.push_back(c);
 		}
+	}
+	return enqueue(codepoints, priority);
+}
+
+std::future<size_t> ftgl::Font::prewarm(const char* codepoints, int priority)
+{
+	assert(codepoints);
+
+	std::vector<uint32_t> ucodepoints;
+	for (const char* c = codepoints; *c; c += utf8_surrogate_len(c))
+	{
+		ucodepoints.push_back(utf8_to_utf32(c));
+	}
+	return enqueue(ucodepoints, priority);
+}
+
+void ftgl::Font::prioritize(const char* codepoints, int priority)
+{
+	assert(codepoints);
+
+	std::vector<uint32_t> ucodepoints;
+	for (const char* c = codepoints; *c; c += utf8_surrogate_len(c))
+	{
+		ucodepoints.push_back(utf8_to_utf32(c));
+	}
+	std::sort(ucodepoints.begin(), ucodepoints.end());
 
-		FT_Error error = FT_Load_Glyph(face, glyph_index, flags);
-		if (error)
+	std::lock_guard<std::mutex> lock(m_mutex);
+	bool changed = false;
+	for (auto&& pending : m_pending)
+	{
+		if (pending.priority < priority && std::binary_search(
+			ucodepoints.begin(), ucodepoints.end(), pending.codepoint))
 		{
-		#ifdef FTGL_STDERR_DISPLAY
-			fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
-				__LINE__, FT_Errors[error].code, FT_Errors[error].message);
-		#endif
-			FT_Done_Face(face);
-			FT_Done_FreeType(library);
-			return utf8_strlen(codepoints) - utf8_strlen(codepoints + i);
+			pending.priority = priority;
+			changed = true;
 		}
+	}
+
+	if (changed)
+	{
+		std::make_heap(m_pending.begin(), m_pending.end(), later);
+	}
+}
 
+std::future<size_t> ftgl::Font::enqueue(
+	const std::vector<uint32_t>& codepoints,
+	int priority)
+{
+	auto job = std::make_shared<Job>();
+	auto done = job->done.get_future();
+	if (codepoints.empty())
+	{
+		job->done.set_value(0);
+		return done;
+	}
+	job->remaining = codepoints.size();
 
-		if (unsigned char(m_outline_type) == 0)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (auto c : codepoints)
 		{
-			slot = face->glyph;
-			ft_bitmap = slot->bitmap;
-			ft_glyph_top = slot->bitmap_top;
-			ft_glyph_left = slot->bitmap_left;
+			queue(c, priority, job);
 		}
-		else
+	}
+	m_wake.notify_one();
+
+	return done;
+}
+
+void ftgl::Font::queue(uint32_t ucodepoint, int priority, std::shared_ptr<Job> job)
+{
+	m_pending.push_back({ priority, m_pending_order++, ucodepoint,
+		m_outline_type, m_outline_thickness, std::move(job) });
+	std::push_heap(m_pending.begin(), m_pending.end(), later);
+
+	if (m_background && !m_worker.joinable())
+	{
+		// The worker writes the atlas while the application uses it
+		assert(m_atlas->concurrent());
+
+		m_worker = std::thread(&Font::work, this);
+	}
+}
+
+void ftgl::Font::setBackgroundLoading(bool background)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_background = background;
+
+	if (background && !m_pending.empty() && !m_worker.joinable())
+	{
+		assert(m_atlas->concurrent());
+		m_worker = std::thread(&Font::work, this);
+	}
+	else if (!background && m_worker.joinable())
+	{
+		m_stop = true;
+		lock.unlock();
+		m_wake.notify_all();
+		m_worker.join();
+		lock.lock();
+		m_stop = false;
+	}
+}
+
+size_t ftgl::Font::pumpPending(unsigned budget_us)
+{
+	using clock = std::chrono::steady_clock;
+	auto start = clock::now();
+	auto deadline = start + std::chrono::microseconds(budget_us);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	size_t count = 0;
+	while (!m_pending.empty() && clock::now() < deadline)
+	{
+		loadNext(lock);
+		count++;
+	}
+
+	// Kerning gets what is left of the budget once the queue is drained
+	bool kern = m_kerning_stale && m_pending.empty();
+	lock.unlock();
+
+	if (kern)
+	{
+		kernGlyphs(deadline, false);
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+		clock::now() - start).count();
+	lock.lock();
+	m_stats.last_pump_us = uint64_t(elapsed);
+	m_stats.pump_us += uint64_t(elapsed);
+
+	return count;
+}
+
+ftgl::LoadStats ftgl::Font::loadStats() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	LoadStats stats = m_stats;
+	stats.pending = m_pending.size();
+	return stats;
+}
+
+const ftgl::Glyph* ftgl::Font::getGlyphAsync(const char* codepoint, int priority)
+{
+	uint32_t ucodepoint = ftgl::utf8_to_utf32(codepoint);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (Glyph* glyph = findGlyph(ucodepoint, m_outline_type, m_outline_thickness))
+		return glyph;
+
+	/* Codepoint nullptr is the background glyph, loaded by init() */
+	if (!codepoint || m_glyphs.empty())
+		return nullptr;
+
+	if (m_absent.count(ucodepoint))
+		return nullptr;
+
+	if (m_requested.insert(ucodepoint).second)
+	{
+		queue(ucodepoint, priority, nullptr);
+		lock.unlock();
+		m_wake.notify_one();
+	}
+	return &m_glyphs.front();
+}
+
+size_t ftgl::Font::addListener(std::function<void(const Glyph&)> listener)
+{
+	std::lock_guard<std::mutex> lock(m_listener_mutex);
+	m_listeners.emplace_back(++m_listener_id, std::move(listener));
+	return m_listener_id;
+}
+
+void ftgl::Font::removeListener(size_t id)
+{
+	std::lock_guard<std::mutex> lock(m_listener_mutex);
+	m_listeners.erase(std::remove_if(m_listeners.begin(), m_listeners.end(),
+		[id](const std::pair<size_t, std::function<void(const Glyph&)>>& listener)
+	{
+		return listener.first == id;
+	}), m_listeners.end());
+}
+
+void ftgl::Font::notify(const Glyph& glyph)
+{
+	std::lock_guard<std::mutex> lock(m_listener_mutex);
+	for (auto&& listener : m_listeners)
+	{
+		listener.second(glyph);
+	}
+}
+
+void ftgl::Font::finish(const Pending& pending, bool missed)
+{
+	/* Requests of getGlyphAsync belong to no job */
+	if (!pending.job)
+	{
+		m_requested.erase(pending.codepoint);
+		return;
+	}
+
+	Job& job = *pending.job;
+	if (missed)
+	{
+		job.missed++;
+	}
+	if (--job.remaining == 0)
+	{
+		job.done.set_value(job.missed);
+	}
+}
+
+bool ftgl::Font::loadNext(std::unique_lock<std::mutex>& lock)
+{
+	std::pop_heap(m_pending.begin(), m_pending.end(), later);
+	Pending next = std::move(m_pending.back());
+	m_pending.pop_back();
+
+	bool missed = false;
+	bool loaded = false;
+	if (!m_absent.count(next.codepoint)
+		&& !findGlyph(next.codepoint, next.outline, next.thickness))
+	{
+		bool absent = false;
+		lock.unlock();
 		{
-			FT_Stroker stroker;
-			FT_BitmapGlyph ft_bitmap_glyph;
-			error = FT_Stroker_New(library, &stroker);
-			if (error)
-			{
-			#ifdef FTGL_STDERR_DISPLAY
-				fprintf(stderr, "FT_Error (0x%02x) : %s\n",
-					FT_Errors[error].code, FT_Errors[error].message);
-			#endif
-
-				FT_Done_Face(face);
-				FT_Stroker_Done(stroker);
-				FT_Done_FreeType(library);
-				return 0;
-			}
-			FT_Stroker_Set(stroker,
-				(int)(m_outline_thickness * HRES),
-				FT_STROKER_LINECAP_ROUND,
-				FT_STROKER_LINEJOIN_ROUND,
-				0);
-			error = FT_Get_Glyph(face->glyph, &ft_glyph);
-			if (error)
-			{
-			#ifdef FTGL_STDERR_DISPLAY
-				fprintf(stderr, "FT_Error (0x%02x) : %s\n",
-					FT_Errors[error].code, FT_Errors[error].message);
-			#endif
-
-				FT_Done_Face(face);
-				FT_Stroker_Done(stroker);
-				FT_Done_FreeType(library);
-				return 0;
-			}
+			auto lease = loadFace(m_size);
 
-			if (unsigned char(m_outline_type) == 1)
-			{
-				error = FT_Glyph_Stroke(&ft_glyph, stroker, 1);
-			}
-			else if (unsigned char(m_outline_type) == 2)
-			{
-				error = FT_Glyph_StrokeBorder(&ft_glyph, stroker, 0, 1);
-			}
-			else if (unsigned char(m_outline_type) == 3)
-			{
-				error = FT_Glyph_StrokeBorder(&ft_glyph, stroker, 1, 1);
-			}
-			if (error)
+			/* Codepoints without a glyph in the face are skipped */
+			if (!lease)
 			{
-			#ifdef FTGL_STDERR_DISPLAY
-				fprintf(stderr, "FT_Error (0x%02x) : %s\n",
-					FT_Errors[error].code, FT_Errors[error].message);
-			#endif
-
-				FT_Done_Face(face);
-				FT_Stroker_Done(stroker);
-				FT_Done_FreeType(library);
-				return 0;
+				missed = true;
 			}
-
-			if (depth == 1)
+			else if (FT_Get_Char_Index(lease.face(), next.codepoint))
 			{
-				error = FT_Glyph_To_Bitmap(&ft_glyph, FT_RENDER_MODE_NORMAL, 0, 1);
-				if (error)
-				{
-				#ifdef FTGL_STDERR_DISPLAY
-					fprintf(stderr, "FT_Error (0x%02x) : %s\n",
-						FT_Errors[error].code, FT_Errors[error].message);
-				#endif
-
-					FT_Done_Face(face);
-					FT_Stroker_Done(stroker);
-					FT_Done_FreeType(library);
-					return 0;
-				}
+				Load load = loadGlyph(lease.library(), lease.face(),
+					next.codepoint, next.outline, next.thickness);
+				missed = load != Load::LOADED && load != Load::ALREADY_LOADED;
+				loaded = load == Load::LOADED;
 			}
 			else
 			{
-				error = FT_Glyph_To_Bitmap(&ft_glyph, FT_RENDER_MODE_LCD, 0, 1);
-				if (error)
-				{
-				#ifdef FTGL_STDERR_DISPLAY
-					fprintf(stderr, "FT_Error (0x%02x) : %s\n",
-						FT_Errors[error].code, FT_Errors[error].message);
-				#endif
-
-					FT_Done_Face(face);
-					FT_Stroker_Done(stroker);
-					FT_Done_FreeType(library);
-					return 0;
-				}
+				absent = true;
 			}
-
-			ft_bitmap_glyph = (FT_BitmapGlyph)ft_glyph;
-			ft_bitmap = ft_bitmap_glyph->bitmap;
-			ft_glyph_top = ft_bitmap_glyph->top;
-			ft_glyph_left = ft_bitmap_glyph->left;
-			FT_Stroker_Done(stroker);
 		}
+		lock.lock();
 
-		// We want each glyph to be separated by at least one black pixel
-		size_t w = ft_bitmap.width / depth;
-		size_t h = ft_bitmap.rows;
+		if (absent && m_absent.insert(next.codepoint).second)
+		{
+			m_stats.absent++;
+		}
 
-		region = m_atlas->getRegion(w + 1, h + 1);
-		if (region.x < 0)
-		{	
-		#ifdef FTGL_STDERR_DISPLAY
-			fprintf(stderr, "Texture atlas is full (line %d)\n", __LINE__);
-		#endif
+		if (loaded)
+		{
+			m_stats.loaded++;
 
-			missed++;
-			continue;
+			const Glyph& glyph =
+				*findGlyph(next.codepoint, next.outline, next.thickness);
+			lock.unlock();
+			notify(glyph);
+			lock.lock();
 		}
-		size_t x = region.x;
-		size_t y = region.y;
-		m_atlas->setRegion(x, y, w, h, ft_bitmap.buffer, ft_bitmap.pitch);
-
-		Glyph glyph;
-		glyph.codepoint = ucodepoint;
-		glyph.width = w;
-		glyph.height = h;
-		glyph.outline_type = m_outline_type;
-		glyph.outline_thickness = m_outline_thickness;
-		glyph.offset_x = ft_glyph_left;
-		glyph.offset_y = ft_glyph_top;
-		glyph.s0 = x / float(width);
-		glyph.t0 = y / float(height);
-		glyph.s1 = (x + glyph.width) / float(width);
-		glyph.t1 = (y + glyph.height) / float(height);
-
-		// Discard hinting to get advance
-		FT_Load_Glyph(face, glyph_index, FT_LOAD_RENDER | FT_LOAD_NO_HINTING);
-		slot = face->glyph;
-		glyph.advance_x = slot->advance.x / HRESf;
-		glyph.advance_y = slot->advance.y / HRESf;
-
-		m_glyphs.push_back(std::move(glyph));
-
-		if (unsigned char(m_outline_type) > 0)
+	}
+
+	if (missed)
+	{
+		m_stats.missed++;
+	}
+	finish(next, missed);
+
+	return loaded;
+}
+
+void ftgl::Font::work()
+{
+	using clock = std::chrono::steady_clock;
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	for (;;)
+	{
+		if (m_kerning_stale && m_pending.empty() && !m_stop)
 		{
-			FT_Done_Glyph(ft_glyph);
+			// Glyphs are kerned while the queue is empty, loading comes first
+			lock.unlock();
+			kernGlyphs(clock::time_point::max(), true);
+			lock.lock();
+			continue;
 		}
-	}
 
-	FT_Done_Face(face);
-	FT_Done_FreeType(library);
-	generateKerning();
+		m_wake.wait(lock, [this] { return m_stop || !m_pending.empty(); });
+		if (m_stop)
+			break;
 
-	return missed;
+		auto start = clock::now();
+		loadNext(lock);
+		m_stats.worker_us += uint64_t(std::chrono::duration_cast<
+			std::chrono::microseconds>(clock::now() - start).count());
+	}
 }
 
-bool ftgl::Font::loadFace(float size, FT_Library *library, FT_Face *face) const
+bool ftgl::Font::rasterize(
+	FT_Library library,
+	FT_Face face,
+	uint32_t ucodepoint,
+	Glyph::Outline outline,
+	float thickness,
+	Bitmap& bitmap) const
 {
-	FT_Matrix matrix = {
-		(int)((1.0 / HRES) * 0x10000L),
-		(int)((0.0) * 0x10000L),
-		(int)((0.0) * 0x10000L),
-		(int)((1.0) * 0x10000L) };
+	FT_Int32 flags = 0;
+	auto depth = m_atlas->depth();
 
-	assert(library);
-	assert(size);
+	FT_UInt glyph_index = FT_Get_Char_Index(face, (FT_ULong)ucodepoint);
+	// WARNING: We use texture-atlas depth to guess if user wants
+	//          LCD subpixel rendering
 
-	/* Initialize library */
-	FT_Error error = FT_Init_FreeType(library);
-	if (error) {
-	#ifdef FTGL_STDERR_DISPLAY
-		fprintf(stderr, "FT_Error (0x%02x) : %s\n",
-		        FT_Errors[error].code, FT_Errors[error].message);
-	#endif
-		return false;
+
+	if (outline != Glyph::Outline::NONE)
+	{
+		flags |= FT_LOAD_NO_BITMAP;
+	}
+	else
+	{
+		flags |= FT_LOAD_RENDER;
 	}
 
-	/* Load face */
-	switch (m_location) 
+	if (!m_hinting)
 	{
-	case TEXTURE_FONT_FILE:
-		error = FT_New_Face(*library, m_filename.generic_string().c_str(),
-			0, face);
-		break;
+		flags |= FT_LOAD_NO_HINTING | FT_LOAD_NO_AUTOHINT;
+	}
+	else
+	{
+		flags |= FT_LOAD_FORCE_AUTOHINT;
+	}
 
-	case TEXTURE_FONT_MEMORY:
-		error = FT_New_Memory_Face(*library,
-			static_cast<const FT_Byte*>(m_memory.base), m_memory.size, 0, face);
-		break;
+	if (depth == 3)
+	{
+		FT_Library_SetLcdFilter(library, FT_LCD_FILTER_LIGHT);
+		flags |= FT_LOAD_TARGET_LCD;
+
+		if (m_filtering)
+		{
+			FT_Library_SetLcdFilterWeights(library,
+				const_cast<unsigned char*>(m_lcd_weights));
+		}
 	}
 
-	if (error) {
+	FT_Error error = FT_Load_Glyph(face, glyph_index, flags);
+	if (error)
+	{
 	#ifdef FTGL_STDERR_DISPLAY
 		fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
-		        __LINE__, FT_Errors[error].code, FT_Errors[error].message);
+			__LINE__, FT_Errors[error].code, FT_Errors[error].message);
 	#endif
-		FT_Done_FreeType(*library);
 		return false;
 	}
 
-	/* Select charmap */
-	error = FT_Select_Charmap(*face, FT_ENCODING_UNICODE);
-	if (error) {
+
+	if (outline == Glyph::Outline::NONE)
+	{
+		FT_GlyphSlot slot = face->glyph;
+		bitmap.bitmap = slot->bitmap;
+		bitmap.top = slot->bitmap_top;
+		bitmap.left = slot->bitmap_left;
+		return true;
+	}
+
+	FT_Stroker stroker;
+	error = FT_Stroker_New(library, &stroker);
+	if (error)
+	{
 	#ifdef FTGL_STDERR_DISPLAY
-		fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
-		        __LINE__, FT_Errors[error].code, FT_Errors[error].message);
+		fprintf(stderr, "FT_Error (0x%02x) : %s\n",
+			FT_Errors[error].code, FT_Errors[error].message);
 	#endif
-
-		FT_Done_Face(*face);
-		FT_Done_FreeType(*library);
 		return false;
 	}
+	FT_Stroker_Set(stroker,
+		(int)(thickness * HRES),
+		FT_STROKER_LINECAP_ROUND,
+		FT_STROKER_LINEJOIN_ROUND,
+		0);
+	error = FT_Get_Glyph(face->glyph, &bitmap.glyph);
+
+	if (!error)
+	{
+		if (outline == Glyph::Outline::LINE)
+		{
+			error = FT_Glyph_Stroke(&bitmap.glyph, stroker, 1);
+		}
+		else if (outline == Glyph::Outline::INNER)
+		{
+			error = FT_Glyph_StrokeBorder(&bitmap.glyph, stroker, 0, 1);
+		}
+		else if (outline == Glyph::Outline::OUTER)
+		{
+			error = FT_Glyph_StrokeBorder(&bitmap.glyph, stroker, 1, 1);
+		}
+	}
 
-	/* Set char size */
-	error = FT_Set_Char_Size(*face, (int)(size * HRES), 0, DPI * HRES, DPI);
+	if (!error)
+	{
+		error = FT_Glyph_To_Bitmap(&bitmap.glyph,
+			depth == 3 ? FT_RENDER_MODE_LCD : FT_RENDER_MODE_NORMAL, 0, 1);
+	}
+	FT_Stroker_Done(stroker);
 
-	if (error) {
+	if (error)
+	{
 	#ifdef FTGL_STDERR_DISPLAY
-		fprintf(stderr, "FT_Error (line %d, code 0x%02x) : %s\n",
-			__LINE__, FT_Errors[error].code, FT_Errors[error].message);
+		fprintf(stderr, "FT_Error (0x%02x) : %s\n",
+			FT_Errors[error].code, FT_Errors[error].message);
 	#endif
-		FT_Done_Face(*face);
-		FT_Done_FreeType(*library);
 		return false;
 	}
 
-	/* Set transform matrix */
-	FT_Set_Transform(*face, &matrix, nullptr);
-
+	FT_BitmapGlyph ft_bitmap_glyph = (FT_BitmapGlyph)bitmap.glyph;
+	bitmap.bitmap = ft_bitmap_glyph->bitmap;
+	bitmap.top = ft_bitmap_glyph->top;
+	bitmap.left = ft_bitmap_glyph->left;
 	return true;
 }
 
-void ftgl::Font::generateKerning()
+ftgl::FaceCache::Lease ftgl::Font::loadFace(float size) const
 {
-	FT_Library library;
-	FT_Face face;
-	FT_UInt glyph_index, prev_index;
-	Glyph* glyph, *prev_glyph;
-	FT_Vector kerning;
+	FT_Matrix matrix = {
+		(int)((1.0 / HRES) * 0x10000L),
+		(int)((0.0) * 0x10000L),
+		(int)((0.0) * 0x10000L),
+		(int)((1.0) * 0x10000L) };
 
+	assert(m_face);
+	assert(size);
 
-	/* Load font */
-	if (!loadFace(m_size, &library, &face))
-		return;
+	/* Lock the shared face at this size */
+	auto lease = FaceCache::acquire(m_face, size, DPI * HRES, DPI);
+	if (!lease)
+		return lease;
 
-	/* For each glyph couple combination, check if kerning is necessary */
-	/* Starts at index 1 since 0 is for the special background glyph */
-	for (size_t i = 1; i < m_glyphs.size(); ++i)
+	/* Set transform matrix, the face may come from a font that set another */
+	FT_Set_Transform(lease.face(), &matrix, nullptr);
+
+	return lease;
+}
+
+/*
+ * Kern the glyphs published since the last call against all the glyphs
+ * before them, one glyph at a time until deadline, or until codepoints are
+ * queued or the font stops if yield is set. A call with a deadline does not
+ * wait for another thread kerning, which takes care of the new glyphs.
+ *
+ * Pairs with a new glyph on the right form its list; pairs with it on the
+ * left are added to the lists of the older glyphs. Lists are built aside
+ * and swapped in, readers of a published glyph never see them change.
+ *
+ * Returns whether every glyph is kerned.
+ */
+bool ftgl::Font::kernGlyphs(std::chrono::steady_clock::time_point deadline,
+	bool yield)
+{
+	using clock = std::chrono::steady_clock;
+
+	std::unique_lock<std::mutex> kerning_lock(m_kerning_mutex, std::defer_lock);
+	if (deadline == clock::time_point::max())
+	{
+		kerning_lock.lock();
+	}
+	else if (!kerning_lock.try_lock())
+	{
+		return false;
+	}
+
+	auto start = clock::now();
+	for (;;)
 	{
-		glyph = &m_glyphs[i];
-		glyph_index = FT_Get_Char_Index(face, glyph->codepoint);
-		glyph->kernings.clear();
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+
+			// Glyphs never move once published, keep pointers to them
+			for (size_t i = m_kern_glyphs.size(); i < m_glyphs.size(); ++i)
+			{
+				m_kern_glyphs.push_back(&m_glyphs[i]);
+			}
+
+			auto now = clock::now();
+			bool done = m_kerned == m_kern_glyphs.size();
+			if (done || now >= deadline
+				|| (yield && (m_stop || !m_pending.empty())))
+			{
+				m_stats.kerning_us += uint64_t(std::chrono::duration_cast<
+					std::chrono::microseconds>(now - start).count());
+				if (done)
+				{
+					m_kerning_stale = false;
+				}
+				return done;
+			}
+		}
 
-		//TODO: Improve this code
-		for (size_t j = 1; j < m_glyphs.size(); ++j)
+		size_t n = m_kerned++;
+		Glyph& glyph = *m_kern_glyphs[n];
+
+		// The face is taken glyph by glyph, loaders wait for one glyph at most
+		auto lease = loadFace(m_size);
+		FT_Face face = lease ? lease.face() : nullptr;
+		FT_UInt index = face ? FT_Get_Char_Index(face, glyph.codepoint) : 0;
+		m_kern_indices.push_back(index);
+
+		/* The special background glyph has no index and never kerns */
+		if (!index || !FT_HAS_KERNING(face))
+			continue;
+
+		auto kernings = std::make_shared<std::vector<Kerning>>();
+		for (size_t i = 0; i <= n; ++i)
 		{
-			prev_glyph = &m_glyphs[i];
-			prev_index = FT_Get_Char_Index(face, prev_glyph->codepoint);
-			FT_Get_Kerning(face, prev_index, glyph_index, FT_KERNING_UNFITTED, &kerning);
+			if (!m_kern_indices[i])
+				continue;
+
+			Glyph& other = *m_kern_glyphs[i];
+			FT_Vector kerning;
+
+			FT_Get_Kerning(face, m_kern_indices[i], index,
+				FT_KERNING_UNFITTED, &kerning);
+			if (kerning.x)
+			{
+				kernings->push_back({ other.codepoint, kerning.x / (HRESf * HRESf) });
+			}
 
+			if (i == n)
+				continue;
+
+			FT_Get_Kerning(face, index, m_kern_indices[i],
+				FT_KERNING_UNFITTED, &kerning);
 			if (kerning.x)
 			{
-				Kerning k = { prev_glyph->codepoint, kerning.x / (HRESf * HRESf) };
-				glyph->kernings.push_back(k);
+				auto others = std::atomic_load(&other.kernings);
+				auto extended = others ?
+					std::make_shared<std::vector<Kerning>>(*others) :
+					std::make_shared<std::vector<Kerning>>();
+				extended->push_back({ glyph.codepoint, kerning.x / (HRESf * HRESf) });
+				std::atomic_store(&other.kernings,
+					std::shared_ptr<const std::vector<Kerning>>(std::move(extended)));
 			}
 		}
+		std::atomic_store(&glyph.kernings,
+			std::shared_ptr<const std::vector<Kerning>>(std::move(kernings)));
 	}
-
-	FT_Done_Face(face);
-	FT_Done_FreeType(library);
 }
 
 ftgl::Glyph* ftgl::Font::findGlyph(uint32_t ucodepoint)
 {
-	for (auto&& glyph : m_glyphs)
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return findGlyph(ucodepoint, m_outline_type, m_outline_thickness);
+}
+
+ftgl::Glyph* ftgl::Font::findGlyph(
+	uint32_t ucodepoint,
+	Glyph::Outline outline,
+	float thickness)
+{
+	size_t index = findIndex(ucodepoint, outline, thickness);
+	return index < m_glyphs.size() ? &m_glyphs[index] : nullptr;
+}
+
+size_t ftgl::Font::findIndex(
+	uint32_t ucodepoint,
+	Glyph::Outline outline,
+	float thickness) const
+{
+	// Scan the packed codepoints, the glyph itself is only read on a match
+	const uint32_t* codepoints = m_metrics.codepoints();
+	for (size_t i = 0; i < m_metrics.size(); ++i)
 	{
+		if (codepoints[i] != ucodepoint)
+			continue;
+
 		// If codepoint is -1, we don't care about outline type or thickness
-		if ((glyph.codepoint == ucodepoint) &&
-			((ucodepoint == -1) ||
-			((glyph.outline_type == m_outline_type) &&
-				(glyph.outline_thickness == m_outline_thickness))))
+		const Glyph& glyph = m_glyphs[i];
+		if ((ucodepoint == -1) ||
+			((glyph.outline_type == outline) &&
+				(glyph.outline_thickness == thickness)))
 		{
-			return &glyph;
+			return i;
 		}
 	}
-	return nullptr;
+	return m_glyphs.size();
+}
+
+void ftgl::Font::publish(Glyph glyph)
+{
+	m_metrics.push_back(glyph);
+	m_glyphs.push_back(std::move(glyph));
+	m_kerning_stale = true;
 }
 
 
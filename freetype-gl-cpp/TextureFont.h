@@ -35,7 +35,20 @@
 
 #include <stdlib.h>
 #include <cstdint>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include "FaceCache.h"
+#include "FontFile.h"
+#include "GlyphMetrics.h"
 #include "TextureAtlas.h"
 
 namespace ftgl
@@ -208,8 +221,11 @@ namespace fs = std::experimental::filesystem;
 
 		/**
 		 * A vector of kerning pairs relative to this glyph.
+		 *
+		 * The list is replaced as a whole, never modified in place, when
+		 * glyphs loaded later kern with this one; read it with getKerning().
 		 */
-		std::vector<Kerning> kernings;
+		std::shared_ptr<const std::vector<Kerning>> kernings;
 
 
 
@@ -222,6 +238,62 @@ namespace fs = std::experimental::filesystem;
 	typedef struct FT_LibraryRec_* FT_Library;
 	typedef struct FT_FaceRec_* FT_Face;
 
+	/**
+	 * Activity of the glyph loader of a font.
+	 */
+	struct LoadStats
+	{
+		/**
+		 * Codepoints waiting to be loaded.
+		 */
+		size_t pending = 0;
+
+		/**
+		 * Glyphs loaded from the queue so far.
+		 */
+		size_t loaded = 0;
+
+		/**
+		 * Queued codepoints that could not be loaded.
+		 */
+		size_t missed = 0;
+
+		/**
+		 * Distinct codepoints found to have no glyph in the face, each
+		 * counted once however often it is asked for.
+		 */
+		size_t absent = 0;
+
+		/**
+		 * Time (in microseconds) the worker spent loading glyphs.
+		 */
+		uint64_t worker_us = 0;
+
+		/**
+		 * Time (in microseconds) spent in pumpPending(), overall and in its
+		 * last call, kerning included.
+		 */
+		uint64_t pump_us = 0;
+		uint64_t last_pump_us = 0;
+
+		/**
+		 * Time (in microseconds) spent kerning new glyphs, on any thread.
+		 */
+		uint64_t kerning_us = 0;
+
+		/**
+		 * Glyphs that reused the atlas region of an identical bitmap, and
+		 * the atlas pixels this saved.
+		 */
+		size_t shared = 0;
+		size_t shared_pixels = 0;
+
+		/**
+		 * Time (in microseconds) spent hashing bitmaps to find them.
+		 */
+		uint64_t hash_us = 0;
+	};
+
 
 	/**
 	 *  Texture font class
@@ -230,9 +302,108 @@ namespace fs = std::experimental::filesystem;
 	{
 	private:
 		/**
-		 * Vector of glyphs contained in this font.
+		 * Glyphs contained in this font. A deque keeps the glyphs in place
+		 * while new ones are published by the loader.
+		 */
+		std::deque<Glyph> m_glyphs;
+
+		/**
+		 * Layout metrics of m_glyphs, entry i for glyph i. Lookups scan its
+		 * codepoints instead of the glyphs themselves.
+		 */
+		GlyphMetricsStore m_metrics;
+
+		/**
+		 * Guards the glyphs and the pending queue.
+		 */
+		mutable std::mutex m_mutex;
+
+		/**
+		 * A codepoint waiting to be loaded in the background.
+		 */
+		struct Job;
+		struct Pending
+		{
+			int priority;
+			uint64_t order;
+			uint32_t codepoint;
+			Glyph::Outline outline;
+			float thickness;
+			std::shared_ptr<Job> job;
+		};
+
+		/**
+		 * Heap of pending codepoints, highest priority then oldest first.
+		 */
+		std::vector<Pending> m_pending;
+		uint64_t m_pending_order = 0;
+
+		/**
+		 * Background loader, started by the first prewarm().
+		 */
+		std::thread m_worker;
+		std::condition_variable m_wake;
+		bool m_stop = false;
+
+		/**
+		 * Whether queued codepoints are loaded by the worker, otherwise only
+		 * pumpPending() loads them.
+		 */
+		bool m_background = true;
+
+		/**
+		 * Whether glyphs were loaded since kerning was last generated.
+		 */
+		bool m_kerning_stale = false;
+
+		/**
+		 * Serializes kernGlyphs(), which owns the fields below: the glyphs
+		 * kerned so far and their index in the face.
+		 */
+		std::mutex m_kerning_mutex;
+		size_t m_kerned = 0;
+		std::vector<Glyph*> m_kern_glyphs;
+		std::vector<unsigned> m_kern_indices;
+
+		/**
+		 * Codepoints queued by getGlyphAsync and not loaded yet.
+		 */
+		std::unordered_set<uint32_t> m_requested;
+
+		/**
+		 * Codepoints the face has no glyph for, never queued again by
+		 * getGlyphAsync.
+		 */
+		std::unordered_set<uint32_t> m_absent;
+
+		/**
+		 * Callbacks told about glyphs loaded in the background.
 		 */
-		std::vector<Glyph> m_glyphs;
+		std::vector<std::pair<size_t, std::function<void(const Glyph&)>>> m_listeners;
+		size_t m_listener_id = 0;
+		std::mutex m_listener_mutex;
+
+		/**
+		 * Atlas region of a loaded bitmap and its size. Bitmaps with the same
+		 * hash are told apart by comparing them with the atlas pixels.
+		 */
+		struct SharedRegion
+		{
+			ivec4 region;
+			unsigned width;
+			unsigned rows;
+		};
+
+		/**
+		 * Atlas regions of the bitmaps loaded so far, by a hash of their
+		 * size and pixels.
+		 */
+		std::unordered_multimap<uint64_t, SharedRegion> m_regions;
+
+		/**
+		 * Loader activity, pending is filled in by loadStats().
+		 */
+		LoadStats m_stats;
 
 		/**
 		 * Atlas structure to store glyphs data.
@@ -265,6 +436,18 @@ namespace fs = std::experimental::filesystem;
 			} m_memory;
 		};
 
+		/**
+		 * Mapping of the font file, shared with the other fonts using it.
+		 * Faces are created from it instead of from m_filename.
+		 */
+		std::shared_ptr<FontFile> m_file;
+
+		/**
+		 * Face shared with the other fonts of the same source, opened by
+		 * init().
+		 */
+		std::shared_ptr<FaceCache::Entry> m_face;
+
 		/**
 		 * Font size
 		 */
@@ -369,20 +552,128 @@ namespace fs = std::experimental::filesystem;
 			size_t memory_size;
 		};
 
+		/**
+		 * An inclusive range of codepoints, e.g. a Unicode block.
+		 */
+		struct Range
+		{
+			uint32_t first;
+			uint32_t last;
+		};
+
 		explicit Font(TextureAtlas* atlas, float pt_size, File file);
 		explicit Font(TextureAtlas* atlas, float pt_size, Memory memory);
+		explicit Font(TextureAtlas* atlas, float pt_size,
+			std::shared_ptr<FontFile> file);
 
-		~Font()
-		{
-		}
+		~Font();
 
-		//NOTE: the pointer returned by getGlyph is only guaranteed to be valid
-		//if no more glyphs are loaded (which may require the vector to expand)
+		//NOTE: glyphs are never moved, the pointer returned by getGlyph stays
+		//valid for the lifetime of the font
 		const Glyph* getGlyph(const char* codepoint);
 		//NOTE: this version does not attempt to load a glyph if not found
 		const Glyph* getLoadedGlyph(uint32_t ucodepoint);
 		size_t loadGlyphs(const char* codepoints);
 
+		/**
+		 * Get the compact metrics of the glyphs of a string, for layout.
+		 *
+		 * Glyphs are loaded as getGlyph() would; those that cannot be loaded
+		 * are left out of the result.
+		 *
+		 * @param text     UTF-8 string
+		 * @param metrics  receives one entry per glyph, in text order
+		 * @return number of codepoints left out
+		 */
+		size_t getMetrics(const char* text, std::vector<GlyphMetrics>& metrics);
+
+		/**
+		 * Get the glyph a GlyphMetrics::index refers to.
+		 */
+		const Glyph* getGlyphAt(size_t index) const;
+
+		/**
+		 * Rasterize every loaded glyph again into its atlas region, e.g. when
+		 * the context of a GPU resident atlas was lost. Only the pixels are
+		 * written again; glyphs and their metrics are left as they are.
+		 *
+		 * @return number of glyphs that could not be restored
+		 */
+		size_t restore();
+
+		/**
+		 * Load glyphs on a background thread.
+		 *
+		 * The codepoints are queued for a worker owned by the font, which
+		 * publishes each glyph as soon as it is in the atlas; getGlyph finds
+		 * it from then on. Codepoints the face has no glyph for are skipped.
+		 * Queued codepoints are loaded by decreasing priority, then in the
+		 * order they were queued. With background loading, the atlas must be
+		 * in concurrent mode as it is written while other threads use it.
+		 *
+		 * @param ranges    codepoints to load
+		 * @param priority  priority of these codepoints
+		 * @return number of codepoints that could not be loaded, once all of
+		 *         them have been processed
+		 */
+		std::future<size_t> prewarm(const std::vector<Range>& ranges,
+			int priority = 0);
+		std::future<size_t> prewarm(const char* codepoints, int priority = 0);
+
+		/**
+		 * Get a glyph without waiting for it to be rasterized.
+		 *
+		 * A glyph not loaded yet is queued for the background worker and the
+		 * special background glyph (codepoint -1) is returned in its place;
+		 * listeners are told once the real glyph is available. Like
+		 * prewarm(), this needs an atlas in concurrent mode unless background
+		 * loading is off. Once the face turned out to have no glyph for the
+		 * codepoint, nullptr is returned without queuing it again.
+		 *
+		 * @param codepoint  codepoint to get, in UTF-8
+		 * @param priority   queue priority, above prewarm() by default
+		 */
+		const Glyph* getGlyphAsync(const char* codepoint, int priority = 1);
+
+		/**
+		 * Register a callback run with every glyph loaded in the background,
+		 * e.g. to lay out again the text that got a placeholder. It runs on
+		 * the loading thread and must not add or remove listeners.
+		 *
+		 * @return id to remove the listener with
+		 */
+		size_t addListener(std::function<void(const Glyph&)> listener);
+		void removeListener(size_t id);
+
+		/**
+		 * Load queued glyphs on the calling thread for at most budget_us
+		 * microseconds, e.g. once per frame; the rest stays queued. Once
+		 * the queue is empty, the rest of the budget kerns the new glyphs.
+		 * The glyph in progress when the budget runs out is finished first.
+		 *
+		 * It can be called from any thread, also while the background
+		 * worker runs: both then take glyphs off the same queue, and the
+		 * kerning the worker is doing is left to it.
+		 *
+		 * @return number of codepoints taken off the queue
+		 */
+		size_t pumpPending(unsigned budget_us);
+
+		/**
+		 * Choose whether queued glyphs are loaded by the background worker
+		 * (the default) or only by pumpPending(). Without the worker, the
+		 * atlas does not need to be in concurrent mode.
+		 */
+		void setBackgroundLoading(bool background);
+
+		LoadStats loadStats() const;
+
+		/**
+		 * Raise the priority of queued codepoints, e.g. those of the text
+		 * currently visible.
+		 */
+		void prioritize(const char* codepoints, int priority);
+
 		operator bool() const
 		{
 			return m_success;
@@ -400,9 +691,37 @@ namespace fs = std::experimental::filesystem;
 
 
 	private:
-		bool loadFace(float size, FT_Library* library, FT_Face* face)const;
-		void generateKerning();
+		struct Bitmap;
+
+		FaceCache::Lease loadFace(float size) const;
+		bool rasterize(FT_Library library, FT_Face face, uint32_t ucodepoint,
+			Glyph::Outline outline, float thickness, Bitmap& bitmap) const;
+		enum class Load
+		{
+			LOADED,
+			ALREADY_LOADED,
+			ATLAS_FULL,
+			FAILED
+		};
+
+		Load loadGlyph(FT_Library library, FT_Face face, uint32_t ucodepoint,
+			Glyph::Outline outline, float thickness);
+		std::future<size_t> enqueue(const std::vector<uint32_t>& codepoints,
+			int priority);
+		void queue(uint32_t ucodepoint, int priority, std::shared_ptr<Job> job);
+		void notify(const Glyph& glyph);
+		void finish(const Pending& pending, bool missed);
+		bool loadNext(std::unique_lock<std::mutex>& lock);
+		static bool later(const Pending& a, const Pending& b);
+		void work();
+		bool kernGlyphs(std::chrono::steady_clock::time_point deadline,
+			bool yield);
+		void publish(Glyph glyph);
 		Glyph* findGlyph(uint32_t ucodepoint);
+		Glyph* findGlyph(uint32_t ucodepoint, Glyph::Outline outline,
+			float thickness);
+		size_t findIndex(uint32_t ucodepoint, Glyph::Outline outline,
+			float thickness) const;
 		bool init();
 	};
 }
@@ -0,0 +1,160 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <vector>
+#include "VertexBuffer.h"
+#include "VertexFormat.h"
+
+namespace ftgl {
+
+/**
+ * Vertex buffer whose layout comes from a vertex struct at compile time.
+ *
+ * Format names the vertex struct (vertex_type) and describes its fields
+ * (fields), see VertexField. The stride is sizeof(vertex_type) and the
+ * attribute offsets are those of the struct, so there is no format string
+ * to parse and vertices can only be given as vertex_type: a layout that
+ * does not match the struct does not compile.
+ *
+ * Storage, uploads and rendering are those of VertexBuffer; attributes
+ * are enabled straight from Format::fields, with no VertexAttribute or
+ * name string allocated per field.
+ */
+template <typename Format>
+class TypedVertexBuffer : private VertexBuffer
+{
+public:
+	using vertex_type = typename Format::vertex_type;
+
+	static constexpr size_t stride = sizeof(vertex_type);
+	static constexpr size_t field_count =
+		sizeof(Format::fields) / sizeof(VertexField);
+
+	static_assert(field_count <= MAX_VERTEX_ATTRIBUTES,
+		"Too many vertex fields");
+	static_assert(validVertexFormat<Format>(),
+		"Vertex fields must lie inside the vertex without overlapping");
+
+	/**
+	 * Offset of the i-th field in the vertex, in bytes.
+	 */
+	static constexpr size_t offset(size_t i)
+	{
+		return Format::fields[i].offset;
+	}
+
+	TypedVertexBuffer() :
+		VertexBuffer(Format::fields, field_count, stride)
+	{
+	}
+
+	using VertexBuffer::size;
+	using VertexBuffer::upload;
+	using VertexBuffer::clear;
+	using VertexBuffer::renderItem;
+	using VertexBuffer::renderItems;
+	using VertexBuffer::setIndirectDraws;
+	using VertexBuffer::setProgram;
+	using VertexBuffer::forgetProgram;
+	using VertexBuffer::setQuadList;
+	using VertexBuffer::isQuadList;
+	using VertexBuffer::render;
+	using VertexBuffer::pushBackIndices;
+	using VertexBuffer::erase;
+	using VertexBuffer::remove;
+	using VertexBuffer::compact;
+	using VertexBuffer::freeVertices;
+	using VertexBuffer::setOrphanThreshold;
+	using VertexBuffer::uploadStats;
+
+	void pushBackVertices(const vertex_type* vertices, size_t vcount)
+	{
+		VertexBuffer::pushBackVertices(
+			reinterpret_cast<const char*>(vertices), vcount);
+	}
+
+	size_t push_back(const vertex_type* vertices, size_t vcount,
+		const GLuint* indices, size_t icount)
+	{
+		return VertexBuffer::push_back(
+			reinterpret_cast<const char*>(vertices), vcount, indices, icount);
+	}
+
+	template <size_t V, size_t I>
+	size_t push_back(const vertex_type (&vertices)[V], const GLuint (&indices)[I])
+	{
+		return push_back(vertices, V, indices, I);
+	}
+
+	size_t push_back(const std::vector<vertex_type>& vertices,
+		const std::vector<GLuint>& indices)
+	{
+		return push_back(vertices.data(), vertices.size(),
+			indices.data(), indices.size());
+	}
+
+	size_t insert(size_t index, const vertex_type* vertices, size_t vcount,
+		const GLuint* indices, size_t icount)
+	{
+		return VertexBuffer::insert(index,
+			reinterpret_cast<const char*>(vertices), vcount, indices, icount);
+	}
+
+	size_t add(const vertex_type* vertices, size_t vcount,
+		const GLuint* indices, size_t icount)
+	{
+		return VertexBuffer::add(
+			reinterpret_cast<const char*>(vertices), vcount, indices, icount);
+	}
+
+	size_t pushBackQuads(const vertex_type* vertices, size_t vcount)
+	{
+		return VertexBuffer::pushBackQuads(
+			reinterpret_cast<const char*>(vertices), vcount);
+	}
+
+	size_t addQuads(const vertex_type* vertices, size_t vcount)
+	{
+		return VertexBuffer::addQuads(
+			reinterpret_cast<const char*>(vertices), vcount);
+	}
+
+	void updateVertices(size_t index, const vertex_type* vertices)
+	{
+		VertexBuffer::updateVertices(index,
+			reinterpret_cast<const char*>(vertices));
+	}
+};
+
+}//namespace ftgl
@@ -1,5 +1,7 @@
 #include "VertexAttribute.h"
+#include <algorithm>
 #include <cstring>
+#include <cstdlib>
 #include <cassert>
 
 ftgl::VertexAttribute::VertexAttribute(std::string name, int size, 
@@ -23,33 +25,125 @@ bool ftgl::VertexAttribute::isValid() const
 	return name.empty();
 }
 
-void ftgl::VertexAttribute::enable()
+size_t ftgl::VertexAttribute::byteSize() const
 {
-	if (index == -1)
+	switch (type)
 	{
-		GLint program;
-		glGetIntegerv(GL_CURRENT_PROGRAM, &program);
-		if (program == 0)
+	case GL_BOOL:           return size * sizeof(GLboolean);
+	case GL_BYTE:           return size * sizeof(GLbyte);
+	case GL_UNSIGNED_BYTE:  return size * sizeof(GLubyte);
+	case GL_SHORT:          return size * sizeof(GLshort);
+	case GL_UNSIGNED_SHORT: return size * sizeof(GLushort);
+	case GL_INT:            return size * sizeof(GLint);
+	case GL_UNSIGNED_INT:   return size * sizeof(GLuint);
+	case GL_FLOAT:          return size * sizeof(GLfloat);
+	default:                return 0;
+	}
+}
+
+size_t ftgl::VertexAttribute::parseFormat(const char* format, size_t max,
+	std::vector<VertexAttribute>& attributes)
+{
+	const char* start = format;
+	const char* end = nullptr;
+	size_t stride = 0;
+	GLchar *pointer = nullptr;
+	do
+	{
+		cstring_view desc;
+		end = strchr(start + 1, ',');
+		if (end == nullptr)
 		{
-			return;
+			desc = start;
+		}
+		else
+		{
+			desc.assign(start, end - start);
 		}
+		VertexAttribute attribute(desc);
+		start = end + 1;
+		attribute.setPointer(pointer);
+		stride += attribute.byteSize();
+		pointer += attribute.byteSize();
+		attributes.push_back(std::move(attribute));
+	} while (end && (attributes.size() < max));
 
-		index = glGetAttribLocation(program, name.c_str());
+	for (auto&& attribute : attributes)
+	{
+		attribute.setStride(stride);
+	}
 
-		if (index == -1)
+	return stride;
+}
+
+GLint ftgl::VertexAttribute::location(GLuint program)
+{
+	if (binding != -1)
+	{
+		return binding;
+	}
+	if (program == 0)
+	{
+		return -1;
+	}
+
+	for (auto&& location : locations)
+	{
+		if (location.first == program)
 		{
-			return;
+			return location.second;
 		}
 	}
+
+	GLint location = glGetAttribLocation(program, name.c_str());
+	locations.emplace_back(program, location);
+	return location;
+}
+
+void ftgl::VertexAttribute::forgetProgram(GLuint program)
+{
+	locations.erase(std::remove_if(locations.begin(), locations.end(),
+		[program](const std::pair<GLuint, GLint>& location)
+		{
+			return location.first == program;
+		}), locations.end());
+}
+
+void ftgl::VertexAttribute::enable(GLuint program)
+{
+	index = location(program);
+	if (index == -1)
+	{
+		return;
+	}
+
 	glEnableVertexAttribArray(index);
 	glVertexAttribPointer(index, size, type,
 		normalized, stride, pointer);
 }
 
+void ftgl::VertexAttribute::enable()
+{
+	GLint program = 0;
+	if (binding == -1)
+	{
+		glGetIntegerv(GL_CURRENT_PROGRAM, &program);
+	}
+	enable(GLuint(program));
+}
+
+void ftgl::VertexAttribute::disable()
+{
+	if (index != -1)
+	{
+		glDisableVertexAttribArray(index);
+	}
+}
+
 void ftgl::VertexAttribute::parse(cstring_view format)
 {
 	/*
-	 *  format: [name]:[size][type][normalized]opt
+	 *  format: [name]:[size][type][normalized]opt[@location]opt
 	 */
 	char ctype;
 	const char *p = format.findPtr(':');
@@ -83,6 +177,11 @@ void ftgl::VertexAttribute::parse(cstring_view format)
 			if (*p == 'n')
 			{
 				normalized = 1;
+				++p;
+			}
+			if (*p == '@')
+			{
+				binding = int(strtol(p + 1, nullptr, 10));
 			}
 		}
 	}
@@ -1,5 +1,6 @@
 #pragma once
 #include <string>
+#include <vector>
 #include "opengl.h"
 #include "Utility.h"
 
@@ -12,6 +13,12 @@ private:
 	int size = 0;
 	int index = -1;
 
+	/** Location given in the format ("@n"), -1 to look it up by name */
+	int binding = -1;
+
+	/** Locations looked up so far, by program */
+	std::vector<std::pair<GLuint, GLint>> locations;
+
 public:
 	std::string getName() const
 	{
@@ -43,6 +50,12 @@ public:
 		stride = s;
 	}
 
+	/** Whether the format gives the location, so no program is needed */
+	bool hasBinding() const
+	{
+		return binding != -1;
+	}
+
 	bool isNormalized() const
 	{
 		return normalized;
@@ -79,7 +92,43 @@ public:
 	VertexAttribute(cstring_view format);
 
 	bool isValid() const;
+
+	/**
+	 * Size in bytes of the attribute in a vertex, 0 for an unknown type
+	 */
+	size_t byteSize() const;
+
+	/**
+	 * Parse a vertex format such as "vertex:3f,tex_coord:2f,color:4f" into
+	 * at most max attributes, with their pointers and stride set. An
+	 * attribute may end with "@n" to be bound to location n, matching a
+	 * layout(location = n) in the shader: "vertex:3f@0,color:4Bn@1".
+	 *
+	 * @return stride of the format in bytes
+	 */
+	static size_t parseFormat(const char* format, size_t max,
+		std::vector<VertexAttribute>& attributes);
+	/**
+	 * Location of the attribute in a program: the one of the format, or
+	 * the one found by name, looked up once per program.
+	 */
+	GLint location(GLuint program);
+
+	/**
+	 * Drop the location looked up in a program, e.g. when it is deleted
+	 * and GL may give its id to another one.
+	 */
+	void forgetProgram(GLuint program);
+
+	/**
+	 * Enable the attribute and set its pointer for a program, or for the
+	 * current program (queried from GL) if none is given.
+	 */
+	void enable(GLuint program);
 	void enable();
+
+	/** Disable the attribute at the location it was last enabled at */
+	void disable();
 	void parse(cstring_view format);
 	void setPointer(void* ptr);
 };
@@ -1,52 +1,55 @@
 #include "VertexBuffer.h"
+#include <algorithm>
+#include <cstring>
+#include "QuadIndexBuffer.h"
 
+static constexpr size_t NO_RANGE = size_t(-1);
 
-ftgl::VertexBuffer::VertexBuffer(const char* format):
-	format(format)
+// First fit in a map of free ranges, splitting the range it takes from
+static size_t takeRange(std::map<size_t, size_t>& ranges, size_t count)
 {
-	const char* start = format;
-	const char* end = nullptr;
-	size_t index = 0, stride = 0;
-	GLchar *pointer = nullptr;
-	do
+	if (!count)
+		return NO_RANGE;
+
+	for (auto it = ranges.begin(); it != ranges.end(); ++it)
 	{
-		cstring_view desc;
-		uint32_t attribute_size = 0;
-		end = strchr(start + 1, ',');
-		if (end == nullptr)
+		if (it->second < count)
+			continue;
+
+		size_t start = it->first;
+		size_t left = it->second - count;
+		ranges.erase(it);
+		if (left)
 		{
-			desc = start;
+			ranges.emplace(start + count, left);
 		}
-		else
-		{
-			desc.assign(start, end - start);
-		}
-		auto attribute = std::make_unique<VertexAttribute>(desc);
-		start = end + 1;
-		attribute->setPointer(pointer);
-		switch (attribute->getType())
-		{
-		case GL_BOOL:           attribute_size = sizeof(GLboolean); break;
-		case GL_BYTE:           attribute_size = sizeof(GLbyte); break;
-		case GL_UNSIGNED_BYTE:  attribute_size = sizeof(GLubyte); break;
-		case GL_SHORT:          attribute_size = sizeof(GLshort); break;
-		case GL_UNSIGNED_SHORT: attribute_size = sizeof(GLushort); break;
-		case GL_INT:            attribute_size = sizeof(GLint); break;
-		case GL_UNSIGNED_INT:   attribute_size = sizeof(GLuint); break;
-		case GL_FLOAT:          attribute_size = sizeof(GLfloat); break;
-		default:                attribute_size = 0;
-		}
-		stride += attribute->getSize()*attribute_size;
-		pointer += attribute->getSize()*attribute_size;
-		attributes[index] = std::move(attribute);
-		++index;
-	} while (end && (index < MAX_VERTEX_ATTRIBUTES));
-	
-	for (size_t i = 0; i<index; ++i)
-	{
-		attributes[i]->setStride(stride);
-	}
-	
+		return start;
+	}
+	return NO_RANGE;
+}
+
+
+ftgl::VertexBuffer::VertexBuffer(const char* format):
+	format(format)
+{
+	std::vector<VertexAttribute> parsed;
+	vertex_stride = VertexAttribute::parseFormat(format, MAX_VERTEX_ATTRIBUTES,
+		parsed);
+
+	for (size_t i = 0; i < parsed.size(); ++i)
+	{
+		attributes[i] = std::make_unique<VertexAttribute>(std::move(parsed[i]));
+	}
+}
+
+ftgl::VertexBuffer::VertexBuffer(const VertexField* fields, size_t count,
+	size_t stride) :
+	fields(fields),
+	field_count(count)
+{
+	assert(count <= MAX_VERTEX_ATTRIBUTES);
+
+	std::fill(std::begin(field_indices), std::end(field_indices), -1);
 	vertex_stride = stride;
 }
 
@@ -69,36 +72,142 @@ void ftgl::VertexBuffer::upload()
 	size_t vsize = vertices.size() *
 		sizeof(decltype(vertices)::value_type);
 
-	size_t isize = indices.size() *
-		sizeof(decltype(indices)::value_type);
+	size_t isize = indices.size() * indices.elementSize();
+
+	// Promoting the indices to 32 bits moved all of them
+	if (indices.type() != GPU_itype)
+	{
+		dirty_indices.clear();
+		markDirty(dirty_indices, 0, isize);
+		GPU_itype = indices.type();
+	}
+
+	size_t sent = upload_stats.bytes_uploaded;
 
 	//Upload vertices
 	glBindBuffer(GL_ARRAY_BUFFER, vertices_id);
+	uploadRanges(GL_ARRAY_BUFFER, vertices.data(), vsize,
+	             GPU_vsize, dirty_vertices);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	//Upload indices
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
+	uploadRanges(GL_ELEMENT_ARRAY_BUFFER, (const char*)indices.data(), isize,
+	             GPU_isize, dirty_indices);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
-	if (vsize != GPU_vsize)
+	sent = upload_stats.bytes_uploaded - sent;
+	if (sent)
 	{
-		glBufferData(GL_ARRAY_BUFFER, vsize, vertices.data(), GL_DYNAMIC_DRAW);
-		GPU_vsize = vsize;
+		upload_stats.uploads++;
 	}
-	else
+	upload_stats.bytes_saved += vsize + isize - sent;
+}
+
+void ftgl::VertexBuffer::uploadRanges(GLenum target, const char* data,
+	size_t size, size_t& GPU_size, std::vector<Range>& ranges)
+{
+	size_t dirty = 0;
+	for (auto&& range : ranges)
 	{
-		glBufferSubData(GL_ARRAY_BUFFER, 0, vsize, vertices.data());
+		range.end = std::min(range.end, size);
+		if (range.begin < range.end)
+		{
+			dirty += range.end - range.begin;
+		}
 	}
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-	//Upload indices
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
-	if (isize != GPU_isize)
+	if (size > GPU_size || dirty > size * orphan_threshold)
 	{
-		glBufferData(GL_ELEMENT_ARRAY_BUFFER, isize,
-		                                    indices.data(), GL_DYNAMIC_DRAW);
-		GPU_isize = isize;
+		// Grow by half at least, so items pushed every frame do not
+		// reallocate every frame
+		if (size > GPU_size)
+		{
+			GPU_size = std::max(size, GPU_size + GPU_size / 2);
+		}
+
+		// Orphan the storage: draws still reading the old one are not
+		// waited for
+		glBufferData(target, GPU_size, nullptr, GL_DYNAMIC_DRAW);
+		if (size)
+		{
+			glBufferSubData(target, 0, size, data);
+		}
+		upload_stats.full_uploads++;
+		upload_stats.bytes_uploaded += size;
 	}
 	else
 	{
-		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, isize, indices.data());
+		for (auto&& range : ranges)
+		{
+			if (range.begin >= range.end)
+				continue;
+
+			glBufferSubData(target, range.begin, range.end - range.begin,
+			                data + range.begin);
+			upload_stats.ranges++;
+			upload_stats.bytes_uploaded += range.end - range.begin;
+		}
 	}
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	ranges.clear();
+}
+
+void ftgl::VertexBuffer::setOrphanThreshold(float fraction)
+{
+	orphan_threshold = fraction;
+}
+
+void ftgl::VertexBuffer::markDirty(std::vector<Range>& ranges, size_t begin, size_t end)
+{
+	if (begin >= end)
+		return;
+
+	// Ranges closer than this are sent as one
+	static constexpr size_t GAP = 256;
+
+	// Past this many ranges, they are merged into the one covering them all
+	static constexpr size_t MAX_RANGES = 32;
+
+	for (size_t i = 0; i < ranges.size();)
+	{
+		Range& range = ranges[i];
+		if (range.begin <= end + GAP && begin <= range.end + GAP)
+		{
+			begin = std::min(begin, range.begin);
+			end = std::max(end, range.end);
+			range = ranges.back();
+			ranges.pop_back();
+
+			// The grown range may now reach ranges already passed
+			i = 0;
+			continue;
+		}
+		++i;
+	}
+
+	if (ranges.size() == MAX_RANGES)
+	{
+		for (auto&& range : ranges)
+		{
+			begin = std::min(begin, range.begin);
+			end = std::max(end, range.end);
+		}
+		ranges.clear();
+	}
+	ranges.push_back({ begin, end });
+}
+
+void ftgl::VertexBuffer::markVertices(size_t first, size_t last)
+{
+	state |= State::DIRTY;
+	markDirty(dirty_vertices, first * vertex_stride, last * vertex_stride);
+}
+
+void ftgl::VertexBuffer::markIndices(size_t first, size_t last)
+{
+	state |= State::DIRTY;
+	markDirty(dirty_indices, first * indices.elementSize(),
+	          last * indices.elementSize());
 }
 
 void ftgl::VertexBuffer::clear()
@@ -107,6 +216,21 @@ void ftgl::VertexBuffer::clear()
 	indices.clear();
 	vertices.clear();
 	items.clear();
+	free_slots.clear();
+	free_vertices.clear();
+	free_indices.clear();
+	dirty_vertices.clear();
+	dirty_indices.clear();
+}
+
+GLenum ftgl::VertexBuffer::indexType() const
+{
+	return quad_list ? QuadIndexBuffer::type() : indices.type();
+}
+
+size_t ftgl::VertexBuffer::indexSize() const
+{
+	return quad_list ? QuadIndexBuffer::elementSize() : indices.elementSize();
 }
 
 void ftgl::VertexBuffer::renderSetup(GLenum mode)
@@ -123,16 +247,40 @@ void ftgl::VertexBuffer::renderSetup(GLenum mode)
 		state = State::CLEAN;
 	}
 
+	GLuint quad_indices_id = 0;
+	if (quad_list)
+	{
+		quad_indices_id = QuadIndexBuffer::reserve(
+			vertices.size() / vertex_stride / 4);
+	}
+
+	GLuint program = renderProgram();
+
 #ifdef FREETYPE_GL_USE_VAO
-	if (VAO_id == 0)
+	if (VAO_id == 0 || VAO_program != program)
 	{
-		// Generate and set up VAO
+		// Generate and set up VAO, or set it up again for the attribute
+		// locations of another program
 
-		glGenVertexArrays(1, &VAO_id);
+		if (VAO_id == 0)
+		{
+			glGenVertexArrays(1, &VAO_id);
+		}
 		glBindVertexArray(VAO_id);
 
 		glBindBuffer(GL_ARRAY_BUFFER, vertices_id);
 
+		// Disable the locations of the previous program first, they may
+		// be reused by other attributes in this one
+		for (auto&& attribute : attributes)
+		{
+			if (attribute)
+			{
+				attribute->disable();
+			}
+		}
+		disableFields();
+
 		for (size_t i = 0; i < MAX_VERTEX_ATTRIBUTES; ++i)
 		{
 			auto* attribute = attributes[i].get();
@@ -142,13 +290,19 @@ void ftgl::VertexBuffer::renderSetup(GLenum mode)
 			}
 			else
 			{
-				attribute->enable();
+				attribute->enable(program);
 			}
 		}
+		enableFields(program);
+		VAO_program = program;
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-		if (!indices.empty())
+		if (quad_list)
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_indices_id);
+		}
+		else if (!indices.empty())
 		{
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
 		}
@@ -169,11 +323,16 @@ void ftgl::VertexBuffer::renderSetup(GLenum mode)
 			}
 			else
 			{
-				attribute->enable;
+				attribute->enable(program);
 			}
 		}
+		enableFields(program);
 
-		if (!indices.empty())
+		if (quad_list)
+		{
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quad_indices_id);
+		}
+		else if (!indices.empty())
 		{
 			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indices_id);
 		}
@@ -183,6 +342,123 @@ void ftgl::VertexBuffer::renderSetup(GLenum mode)
 }
 
 
+GLuint ftgl::VertexBuffer::renderProgram()
+{
+	if (program_id)
+		return program_id;
+
+	// Locations given by the format do not depend on the program; the
+	// fields of a typed format are always looked up by name
+	bool bound = field_count == 0;
+	for (auto&& attribute : attributes)
+	{
+		if (attribute && !attribute->hasBinding())
+		{
+			bound = false;
+		}
+	}
+	if (bound)
+		return 0;
+
+	// Querying the program may stall the pipeline: ask only until a draw
+	// finds one
+	if (!found_program)
+	{
+		GLint current = 0;
+		glGetIntegerv(GL_CURRENT_PROGRAM, &current);
+		found_program = GLuint(current);
+	}
+	return found_program;
+}
+
+const GLint* ftgl::VertexBuffer::fieldLocations(GLuint program)
+{
+	if (program == 0)
+		return nullptr;
+
+	for (size_t i = 0; i < field_programs.size(); ++i)
+	{
+		if (field_programs[i] == program)
+			return &field_locations[i * field_count];
+	}
+
+	field_programs.push_back(program);
+	for (size_t i = 0; i < field_count; ++i)
+	{
+		field_locations.push_back(glGetAttribLocation(program, fields[i].name));
+	}
+	return &field_locations[field_locations.size() - field_count];
+}
+
+void ftgl::VertexBuffer::enableFields(GLuint program)
+{
+	if (!field_count)
+		return;
+
+	const GLint* locations = fieldLocations(program);
+	for (size_t i = 0; i < field_count; ++i)
+	{
+		const VertexField& field = fields[i];
+		field_indices[i] = locations ? locations[i] : -1;
+		if (field_indices[i] == -1)
+			continue;
+
+		glEnableVertexAttribArray(field_indices[i]);
+		glVertexAttribPointer(field_indices[i], field.size, field.type,
+			field.normalized, GLsizei(vertex_stride),
+			reinterpret_cast<const void*>(field.offset));
+	}
+}
+
+void ftgl::VertexBuffer::disableFields()
+{
+	for (size_t i = 0; i < field_count; ++i)
+	{
+		if (field_indices[i] != -1)
+		{
+			glDisableVertexAttribArray(field_indices[i]);
+		}
+	}
+}
+
+void ftgl::VertexBuffer::setProgram(GLuint program)
+{
+	program_id = program;
+}
+
+void ftgl::VertexBuffer::forgetProgram(GLuint program)
+{
+	for (auto&& attribute : attributes)
+	{
+		if (attribute)
+		{
+			attribute->forgetProgram(program);
+		}
+	}
+
+	for (size_t i = 0; i < field_programs.size(); ++i)
+	{
+		if (field_programs[i] == program)
+		{
+			field_programs.erase(field_programs.begin() + i);
+			field_locations.erase(field_locations.begin() + i * field_count,
+				field_locations.begin() + (i + 1) * field_count);
+			break;
+		}
+	}
+
+	if (found_program == program)
+	{
+		found_program = 0;
+	}
+#ifdef FREETYPE_GL_USE_VAO
+	if (VAO_program == program)
+	{
+		VAO_program = 0;
+	}
+#endif
+}
+
 void ftgl::VertexBuffer::renderFinish()
 {
 #ifdef FREETYPE_GL_USE_VAO
@@ -198,9 +474,10 @@ void ftgl::VertexBuffer::renderFinish()
 			}
 			else
 			{
-				glDisableVertexAttribArray(attribute->getIndex());
+				attribute->disable();
 			}
 		}
+		disableFields();
 
 		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
@@ -212,10 +489,16 @@ void ftgl::VertexBuffer::renderItem(size_t index)
 	assert(index < items.size());
 
 	auto item = items[index];
-	if (!indices.empty())
+	if (item.vstart < 0)
+	{
+		// Removed item
+		return;
+	}
+
+	if (hasIndices())
 	{
-		glDrawElements(mode, item.icount, GL_UNSIGNED_INT,
-		               (void*)(item.istart * sizeof(GLuint)));
+		glDrawElements(mode, item.icount, indexType(),
+		               (void*)(item.istart * indexSize()));
 	}
 	else if (!vertices.empty())
 	{
@@ -225,15 +508,121 @@ void ftgl::VertexBuffer::renderItem(size_t index)
 	}
 }
 
+void ftgl::VertexBuffer::renderItems(GLenum mode, const size_t* handles,
+	size_t count)
+{
+	bool indexed = hasIndices();
+
+	draw_firsts.clear();
+	draw_counts.clear();
+	for (size_t i = 0; i < count; ++i)
+	{
+		assert(handles[i] < items.size());
+
+		const ivec4& item = items[handles[i]];
+		if (item.vstart < 0)
+		{
+			// Removed item
+			continue;
+		}
+
+		GLint first = indexed ? item.istart : item.vstart;
+		GLsizei size = indexed ? item.icount : item.vcount;
+		if (size == 0)
+			continue;
+
+		if (!draw_firsts.empty() &&
+			draw_firsts.back() + draw_counts.back() == first)
+		{
+			draw_counts.back() += size;
+		}
+		else
+		{
+			draw_firsts.push_back(first);
+			draw_counts.push_back(size);
+		}
+	}
+
+	if (draw_firsts.empty())
+		return;
+
+	renderSetup(mode);
+
+	GLsizei ranges = GLsizei(draw_firsts.size());
+	if (!indexed)
+	{
+		glMultiDrawArrays(mode, draw_firsts.data(), draw_counts.data(), ranges);
+	}
+#ifdef GL_DRAW_INDIRECT_BUFFER
+	else if (indirect_draws)
+	{
+		bool changed = draw_commands.size() != draw_firsts.size();
+		draw_commands.resize(draw_firsts.size());
+		for (size_t i = 0; i < draw_firsts.size(); ++i)
+		{
+			DrawCommand command{ GLuint(draw_counts[i]), 1,
+				GLuint(draw_firsts[i]), 0, 0 };
+			if (memcmp(&draw_commands[i], &command, sizeof(command)) != 0)
+			{
+				draw_commands[i] = command;
+				changed = true;
+			}
+		}
+
+		if (!indirect_id)
+		{
+			glGenBuffers(1, &indirect_id);
+			changed = true;
+		}
+
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_id);
+		if (changed)
+		{
+			size_t size = draw_commands.size() * sizeof(DrawCommand);
+			if (size > GPU_indirect_size)
+			{
+				glBufferData(GL_DRAW_INDIRECT_BUFFER, size,
+					draw_commands.data(), GL_DYNAMIC_DRAW);
+				GPU_indirect_size = size;
+			}
+			else
+			{
+				glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size,
+					draw_commands.data());
+			}
+		}
+		glMultiDrawElementsIndirect(mode, indexType(), nullptr, ranges, 0);
+		glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	}
+#endif
+	else
+	{
+		draw_offsets.resize(draw_firsts.size());
+		for (size_t i = 0; i < draw_firsts.size(); ++i)
+		{
+			draw_offsets[i] = (void*)(draw_firsts[i] * indexSize());
+		}
+		glMultiDrawElements(mode, draw_counts.data(), indexType(),
+		                    draw_offsets.data(), ranges);
+	}
+
+	renderFinish();
+}
+
+void ftgl::VertexBuffer::setIndirectDraws(bool enable)
+{
+	indirect_draws = enable;
+}
+
 void ftgl::VertexBuffer::render(GLenum mode)
 {
 	size_t vcount = vertices.size();
-	size_t icount = indices.size();
+	size_t icount = quad_list ? vcount / vertex_stride / 4 * 6 : indices.size();
 	renderSetup(mode);
 
 	if (icount)
 	{
-		glDrawElements(mode, icount, GL_UNSIGNED_INT, nullptr);
+		glDrawElements(mode, icount, indexType(), nullptr);
 	}
 	else
 	{
@@ -244,42 +633,44 @@ void ftgl::VertexBuffer::render(GLenum mode)
 
 void ftgl::VertexBuffer::pushBackIndices(const GLuint* pindices, size_t icount)
 {
-	state |= State::DIRTY;
-	//memcpy the indices at the end of the vector
 	auto end = indices.size();
-	indices.resize(end + icount);
-	memcpy(&indices[end], pindices, icount * sizeof(GLuint));
+	indices.append(pindices, icount);
+	markIndices(end, indices.size());
 }
 
 void ftgl::VertexBuffer::pushBackVertices(const char* pvertices, size_t vcount)
 {
-	state |= State::DIRTY;
+	size_t end = vertices.size() / vertex_stride;
 	vertices.insert(vertices.end(), 
 		pvertices,
 		pvertices + vcount * vertex_stride);
+	markVertices(end, end + vcount);
 }
 
 void ftgl::VertexBuffer::insertIndices(size_t index, const GLuint* pindices, size_t icount)
 {
 	assert(index <= indices.size());
 
-	indices.insert(indices.end(), pindices, pindices + icount);
+	indices.append(pindices, icount);
+	markIndices(index, indices.size());
 }
 
 void ftgl::VertexBuffer::insertVertices(size_t index, const char* pvertices, size_t vcount)
 {
 	assert(index <= vertices.size());
 
-	state |= State::DIRTY;
 	//update the indices
-	for (auto&& idx : indices)
+	for (size_t i = 0; i < indices.size(); ++i)
 	{
-		if (idx > index)
-			idx += index;
+		if (indices[i] > index)
+			indices.set(i, indices[i] + index);
 	}
 
 	vertices.insert(vertices.begin() + index,
 	                pvertices, pvertices + vcount * vertex_stride);
+	state |= State::DIRTY;
+	markDirty(dirty_vertices, index, vertices.size());
+	markIndices(0, indices.size());
 }
 
 void ftgl::VertexBuffer::eraseIndices(size_t first, size_t last)
@@ -287,8 +678,8 @@ void ftgl::VertexBuffer::eraseIndices(size_t first, size_t last)
 	assert(first < last);
 	assert(last < indices.size());
 
-	state |= State::DIRTY;
-	indices.erase(indices.begin() + first, indices.begin() + last);
+	indices.erase(first, last);
+	markIndices(first, indices.size());
 }
 
 void ftgl::VertexBuffer::eraseVertices(size_t first, size_t last)
@@ -296,18 +687,17 @@ void ftgl::VertexBuffer::eraseVertices(size_t first, size_t last)
 	assert(first < last);
 	assert(last * vertex_stride < vertices.size());
 
-	state |= State::DIRTY;
-
 	//update the indices
-	for (auto&& idx : indices)
+	for (size_t i = 0; i < indices.size(); ++i)
 	{
-		if (idx > first)
-			idx -= (last - first);
+		if (indices[i] > first)
+			indices.set(i, indices[i] - GLuint(last - first));
 	}
+	markIndices(0, indices.size());
 
-	first *= vertex_stride;
-	last *= vertex_stride;
-	vertices.erase(vertices.begin() + first, vertices.begin() + last);
+	vertices.erase(vertices.begin() + first * vertex_stride,
+	               vertices.begin() + last * vertex_stride);
+	markVertices(first, vertices.size() / vertex_stride);
 }
 
 size_t ftgl::VertexBuffer::push_back(const char* pvertices, size_t vcount, const GLuint* pindices, size_t icount)
@@ -318,8 +708,9 @@ size_t ftgl::VertexBuffer::push_back(const char* pvertices, size_t vcount, const
 size_t ftgl::VertexBuffer::insert(size_t index, const char* pvertices, size_t vcount, const GLuint* pindices, size_t icount)
 {
 	assert(pvertices);
-	assert(pindices);
+	assert(quad_list ? icount == 0 && vcount % 4 == 0 : pindices != nullptr);
 	assert(index <= items.size());
+	assert(index == items.size() || free_slots.empty());
 
 	state = State::FROZEN;
 
@@ -327,14 +718,18 @@ size_t ftgl::VertexBuffer::insert(size_t index, const char* pvertices, size_t vc
 	size_t vstart = vertices.size() / vertex_stride;
 	pushBackVertices(pvertices, vcount);
 
-	//push back the indices
+	//push back the indices, rebased to match to the right vertex
 	size_t istart = indices.size();
-	pushBackIndices(pindices, icount);
-
-	//update the new indices to match to the right vertex
-	for (size_t i = 0; i < icount; ++i)
+	if (quad_list)
 	{
-		indices[istart + i] += vstart;
+		// Drawn through the shared quad indices
+		istart = vstart / 4 * 6;
+		icount = vcount / 4 * 6;
+	}
+	else
+	{
+		indices.append(pindices, icount, GLuint(vstart));
+		markIndices(istart, indices.size());
 	}
 
 	//insert item
@@ -349,6 +744,13 @@ size_t ftgl::VertexBuffer::insert(size_t index, const char* pvertices, size_t vc
 void ftgl::VertexBuffer::erase(size_t index)
 {
 	assert(index < items.size());
+	assert(free_slots.empty());
+
+	// Shifting the items below would leave the holes behind
+	if (!free_vertices.empty() || !free_indices.empty())
+	{
+		compact();
+	}
 
 	auto delItem = items[index];
 
@@ -362,8 +764,229 @@ void ftgl::VertexBuffer::erase(size_t index)
 		}
 	}
 	state = State::FROZEN;
-	eraseIndices(delItem.istart, delItem.istart + delItem.icount);
+	if (!quad_list)
+	{
+		eraseIndices(delItem.istart, delItem.istart + delItem.icount);
+	}
 	eraseVertices(delItem.vstart, delItem.vstart + delItem.vcount);
 	items.erase(items.begin() + index);
 	state = State::DIRTY;
 }
+
+void ftgl::VertexBuffer::setQuadList(bool enable)
+{
+	assert(items.empty() && indices.empty());
+
+	quad_list = enable;
+}
+
+size_t ftgl::VertexBuffer::pushBackQuads(const char* pvertices, size_t vcount)
+{
+	assert(quad_list);
+
+	return insert(items.size(), pvertices, vcount, nullptr, 0);
+}
+
+size_t ftgl::VertexBuffer::addQuads(const char* pvertices, size_t vcount)
+{
+	assert(quad_list);
+
+	return add(pvertices, vcount, nullptr, 0);
+}
+
+size_t ftgl::VertexBuffer::add(const char* pvertices, size_t vcount, const GLuint* pindices, size_t icount)
+{
+	assert(pvertices);
+	assert(quad_list ? icount == 0 && vcount % 4 == 0 : pindices != nullptr);
+
+	size_t vstart = takeRange(free_vertices, vcount);
+	if (vstart == NO_RANGE)
+	{
+		vstart = vertices.size() / vertex_stride;
+		vertices.resize(vertices.size() + vcount * vertex_stride);
+	}
+	if (vcount)
+	{
+		memcpy(&vertices[vstart * vertex_stride], pvertices,
+		       vcount * vertex_stride);
+	}
+
+	markVertices(vstart, vstart + vcount);
+
+	size_t istart;
+	if (quad_list)
+	{
+		// Holes are made of whole quads, so vstart stays a multiple of 4
+		istart = vstart / 4 * 6;
+		icount = vcount / 4 * 6;
+	}
+	else
+	{
+		istart = takeRange(free_indices, icount);
+		if (istart == NO_RANGE)
+		{
+			istart = indices.size();
+			indices.resize(indices.size() + icount);
+		}
+		for (size_t i = 0; i < icount; ++i)
+		{
+			indices.set(istart + i, pindices[i] + GLuint(vstart));
+		}
+		markIndices(istart, istart + icount);
+	}
+
+	ivec4 item{ int(vstart), int(vcount), int(istart), int(icount) };
+	size_t handle = items.size();
+	if (!free_slots.empty())
+	{
+		handle = free_slots.back();
+		free_slots.pop_back();
+		items[handle] = item;
+	}
+	else
+	{
+		items.push_back(item);
+	}
+
+	return handle;
+}
+
+void ftgl::VertexBuffer::remove(size_t handle)
+{
+	assert(handle < items.size());
+	assert(items[handle].vstart >= 0);
+
+	auto item = items[handle];
+
+	if (quad_list)
+	{
+		// The shared indices cannot change: collapse the quads instead,
+		// all their corners at the same place
+		std::fill(vertices.begin() + item.vstart * vertex_stride,
+		          vertices.begin() + (item.vstart + item.vcount) * vertex_stride, 0);
+		markVertices(item.vstart, item.vstart + item.vcount);
+	}
+	else
+	{
+		// Degenerate primitives rasterize nothing, without moving anything.
+		// Vertex 0 stays valid when the vertices at the end are released.
+		indices.fill(item.istart, item.istart + item.icount, 0);
+		markIndices(item.istart, item.istart + item.icount);
+		freeRange(free_indices, item.istart, item.icount);
+	}
+
+	freeRange(free_vertices, item.vstart, item.vcount);
+
+	items[handle] = ivec4{ -1, 0, -1, 0 };
+	free_slots.push_back(handle);
+}
+
+void ftgl::VertexBuffer::freeRange(std::map<size_t, size_t>& ranges, size_t start, size_t count)
+{
+	if (!count)
+		return;
+
+	auto next = ranges.lower_bound(start);
+
+	// Merge with the following range
+	if (next != ranges.end() && start + count == next->first)
+	{
+		count += next->second;
+		next = ranges.erase(next);
+	}
+
+	// Merge with the preceding range
+	if (next != ranges.begin())
+	{
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == start)
+		{
+			start = prev->first;
+			count += prev->second;
+			ranges.erase(prev);
+		}
+	}
+
+	// A hole at the end just shortens the buffer
+	if (&ranges == &free_vertices && (start + count) * vertex_stride == vertices.size())
+	{
+		vertices.resize(start * vertex_stride);
+		return;
+	}
+	if (&ranges == &free_indices && start + count == indices.size())
+	{
+		indices.resize(start);
+		return;
+	}
+
+	ranges.emplace(start, count);
+}
+
+void ftgl::VertexBuffer::compact()
+{
+	if (free_vertices.empty() && free_indices.empty())
+		return;
+
+	std::vector<char> packed_vertices;
+	IndexArray packed_indices;
+	packed_vertices.reserve(vertices.size() - freeVertices() * vertex_stride);
+	packed_indices.reserve(indices.size());
+
+	for (auto&& item : items)
+	{
+		if (item.vstart < 0)
+			continue;
+
+		size_t vstart = packed_vertices.size() / vertex_stride;
+		size_t istart = packed_indices.size();
+
+		auto first = vertices.begin() + item.vstart * vertex_stride;
+		packed_vertices.insert(packed_vertices.end(),
+		                       first, first + item.vcount * vertex_stride);
+
+		if (quad_list)
+		{
+			istart = vstart / 4 * 6;
+		}
+		else
+		{
+			for (int i = 0; i < item.icount; ++i)
+			{
+				packed_indices.push_back(
+					indices[item.istart + i] - item.vstart + GLuint(vstart));
+			}
+		}
+
+		item.vstart = int(vstart);
+		item.istart = int(istart);
+	}
+
+	vertices.swap(packed_vertices);
+	indices.swap(packed_indices);
+	free_vertices.clear();
+	free_indices.clear();
+
+	markVertices(0, vertices.size() / vertex_stride);
+	markIndices(0, indices.size());
+}
+
+size_t ftgl::VertexBuffer::freeVertices() const
+{
+	size_t count = 0;
+	for (auto&& range : free_vertices)
+	{
+		count += range.second;
+	}
+	return count;
+}
+
+void ftgl::VertexBuffer::updateVertices(size_t index, const char* pvertices)
+{
+	assert(index < items.size());
+	assert(items[index].vstart >= 0);
+
+	auto item = items[index];
+	memcpy(&vertices[item.vstart * vertex_stride], pvertices,
+	       item.vcount * vertex_stride);
+	markVertices(item.vstart, item.vstart + item.vcount);
+}
@@ -1,10 +1,13 @@
 #pragma once
 #include <vector>
+#include <map>
 #include <memory>
 #include <string>
 #include "vec234.h"
 #include "opengl.h"
 #include "VertexAttribute.h"
+#include "VertexFormat.h"
+#include "IndexArray.h"
 
 static constexpr int MAX_VERTEX_ATTRIBUTES = 16;
 #define FREETYPE_GL_USE_VAO
@@ -19,14 +22,45 @@ private:
 	std::vector<char> vertices;
 	size_t vertex_stride = 0;
 
-	std::vector<GLuint> indices;
+	/** 16-bit until a vertex past 65535 is indexed, 32-bit after */
+	IndexArray indices;
 	std::vector<ivec4> items;
 
+	/** Slots of removed items, reused by add(). */
+	std::vector<size_t> free_slots;
+
+	/** Ranges (start -> count) of vertices and indices left by remove(). */
+	std::map<size_t, size_t> free_vertices;
+	std::map<size_t, size_t> free_indices;
+
 	//TODO: replace with std::vector
 	std::unique_ptr<VertexAttribute> attributes[MAX_VERTEX_ATTRIBUTES];
+
+	/**
+	 * Compile-time format of a TypedVertexBuffer, enabled straight from
+	 * its static table instead of through attributes
+	 */
+	const VertexField* fields = nullptr;
+	size_t field_count = 0;
+
+	/** Locations of the fields looked up so far, field_count per program */
+	std::vector<GLuint> field_programs;
+	std::vector<GLint> field_locations;
+
+	/** Locations the fields were last enabled at, -1 if not found */
+	GLint field_indices[MAX_VERTEX_ATTRIBUTES] = {};
 #ifdef FREETYPE_GL_USE_VAO
 	uint32_t VAO_id = 0;
+
+	/** Program whose attribute locations the VAO was set up with */
+	GLuint VAO_program = 0;
 #endif
+	/** Program set with setProgram(), 0 to use the current one */
+	GLuint program_id = 0;
+
+	/** Program in use at the first draw, when none was set */
+	GLuint found_program = 0;
+
 	/** GL identity of the vertices buffer. */
 	uint32_t vertices_id = 0;
 
@@ -39,6 +73,47 @@ private:
 	/** Current size of the indices buffer in GPU*/
 	size_t GPU_isize = 0;
 
+	/** Type of the indices in GPU, sent whole again when it changes */
+	GLenum GPU_itype = GL_UNSIGNED_SHORT;
+
+	/** Byte range [begin, end) of an array modified since the last upload */
+	struct Range
+	{
+		size_t begin;
+		size_t end;
+	};
+
+	/** Modified ranges of the vertices and indices, coalesced */
+	std::vector<Range> dirty_vertices;
+	std::vector<Range> dirty_indices;
+
+	/** Fraction of a buffer above which it is orphaned and sent whole */
+	float orphan_threshold = 0.5f;
+
+	/** Ranges (first index or vertex, count) drawn by renderItems() */
+	std::vector<GLint> draw_firsts;
+	std::vector<GLsizei> draw_counts;
+	std::vector<const void*> draw_offsets;
+
+	/** Layout of glMultiDrawElementsIndirect commands */
+	struct DrawCommand
+	{
+		GLuint count;
+		GLuint instance_count;
+		GLuint first_index;
+		GLint base_vertex;
+		GLuint base_instance;
+	};
+
+	/** Commands of the last indirect renderItems(), as in indirect_id */
+	std::vector<DrawCommand> draw_commands;
+	uint32_t indirect_id = 0;
+	size_t GPU_indirect_size = 0;
+	bool indirect_draws = false;
+
+	/** Whether items are quads drawn through the QuadIndexBuffer */
+	bool quad_list = false;
+
 	/** GL primitives to render. */
 	GLenum mode = GL_TRIANGLES;
 
@@ -52,19 +127,108 @@ private:
 
 	uint8_t state = State::DIRTY;
 
+public:
+	/** Data sent by upload() since the buffer was created. */
+	struct UploadStats
+	{
+		/** Calls to upload() that sent something */
+		size_t uploads = 0;
+
+		/** glBufferSubData calls for dirty ranges */
+		size_t ranges = 0;
+
+		/**
+		 * Arrays reallocated or orphaned to be sent whole; an upload that
+		 * sends both arrays whole counts twice
+		 */
+		size_t full_uploads = 0;
+
+		/** Bytes sent */
+		size_t bytes_uploaded = 0;
+
+		/** Bytes a full upload of both arrays would have sent on top */
+		size_t bytes_saved = 0;
+	};
+
+private:
+	UploadStats upload_stats;
+
 
 public:
 	VertexBuffer(const char* format);
 
+	/**
+	 * Draw with a compile-time vertex format, see TypedVertexBuffer. The
+	 * fields are read from their table at each setup, so it must outlive
+	 * the buffer; no VertexAttribute is built. getFormat() is empty for
+	 * such buffers.
+	 */
+	VertexBuffer(const VertexField* fields, size_t count, size_t stride);
+
 	const char* getFormat() const;
 	size_t size() const
 	{
 		return items.size();
 	}
 
+	/**
+	 * Send the byte ranges modified since the previous upload. A buffer
+	 * that grew is reallocated and sent whole; one with more than the
+	 * orphan threshold modified is orphaned and sent whole, so the driver
+	 * does not have to wait for draws still reading it.
+	 */
 	void upload();
+
+	/**
+	 * Fraction (0 to 1) of a buffer that may be modified before upload()
+	 * sends it whole instead of range by range, 0.5 by default.
+	 */
+	void setOrphanThreshold(float fraction);
+
+	const UploadStats& uploadStats() const
+	{
+		return upload_stats;
+	}
 	void clear();
 	void renderItem(size_t index);
+
+	/**
+	 * Draw a subset of the items with a single multi-draw call.
+	 *
+	 * Items whose indices (or vertices, without indices) follow each other
+	 * in the buffer are merged into one range, so handles given in
+	 * increasing order merge best; ranges are drawn in the given order.
+	 * Removed items are skipped.
+	 */
+	void renderItems(GLenum mode, const size_t* handles, size_t count);
+	void renderItems(GLenum mode, const std::vector<size_t>& handles)
+	{
+		renderItems(mode, handles.data(), handles.size());
+	}
+
+	/**
+	 * Have renderItems() draw indexed items with
+	 * glMultiDrawElementsIndirect, from a buffer of commands that is only
+	 * sent again when the drawn ranges change. Needs GL 4.3 or
+	 * ARB_multi_draw_indirect; ignored if the GL headers lack it.
+	 */
+	void setIndirectDraws(bool enable);
+
+	/**
+	 * Program the buffer is drawn with: attribute locations are looked up
+	 * once per program and the VAO is set up again when the program
+	 * changes. With 0, the default, the program in use is queried until a
+	 * draw finds one, then kept: call setProgram() to draw with another
+	 * one. A format giving every location ("@n") needs no program.
+	 */
+	void setProgram(GLuint program);
+
+	/**
+	 * Forget the attribute locations looked up in a program, before it is
+	 * deleted and GL may give its id to another one. A VAO set up for it
+	 * is set up again at the next draw.
+	 */
+	void forgetProgram(GLuint program);
 	void render(GLenum mode);
 	void pushBackIndices(const GLuint* pindices, size_t icount);
 	void pushBackVertices(const char* pvertices, size_t vcount);
@@ -78,8 +242,89 @@ public:
 	              const GLuint* pindices, size_t icount);
 	void erase(size_t index);
 
+	/**
+	 * Overwrite the vertices of an item, e.g. to change its color; only
+	 * their bytes are uploaded again.
+	 *
+	 * @param index      position or handle of the item
+	 * @param pvertices  as many vertices as the item has
+	 */
+	void updateVertices(size_t index, const char* pvertices);
+
+	/**
+	 * Switch an empty buffer to quad-list mode, or back.
+	 *
+	 * Items of a quad list are given by their vertices only, 4 per quad
+	 * with the corners in the order of QuadIndexBuffer, and are drawn
+	 * through the index buffer shared by all quad lists: the buffer
+	 * stores, rebases and uploads no indices. Removed items have their
+	 * vertices zeroed instead of their indices. Use pushBackQuads() and
+	 * addQuads() to add items, with an indexed primitive such as
+	 * GL_TRIANGLES.
+	 */
+	void setQuadList(bool enable);
+	bool isQuadList() const
+	{
+		return quad_list;
+	}
+
+	/** Append an item of vcount / 4 quads to a quad list */
+	size_t pushBackQuads(const char* pvertices, size_t vcount);
+
+	/** add() an item of vcount / 4 quads to a quad list */
+	size_t addQuads(const char* pvertices, size_t vcount);
+
+	/**
+	 * Add an item that keeps its handle until it is removed.
+	 *
+	 * The vertices and indices go to the first holes left by remove() that
+	 * are large enough, or to the end of the buffer. Handles index the
+	 * items like positions do, but are not shifted by other items being
+	 * removed; insert() in the middle and erase() must not be used while
+	 * handles are given out.
+	 *
+	 * @return handle of the item
+	 */
+	size_t add(const char* pvertices, size_t vcount,
+	           const GLuint* pindices, size_t icount);
+
+	/**
+	 * Remove an item added with add(), without moving any other item. Its
+	 * indices are made degenerate (they all point to the first vertex) so
+	 * render() draws nothing for it, and its vertices and indices become
+	 * holes for later items.
+	 */
+	void remove(size_t handle);
+
+	/**
+	 * Squeeze the holes left by remove() out of the buffer. Items keep
+	 * their handles; vertices and indices that belong to no item are
+	 * dropped.
+	 */
+	void compact();
+
+	/** Number of vertices in holes, e.g. to decide when to compact(). */
+	size_t freeVertices() const;
+
 private:
+	bool hasIndices() const
+	{
+		return quad_list || !indices.empty();
+	}
+	GLenum indexType() const;
+	size_t indexSize() const;
+	GLuint renderProgram();
+	const GLint* fieldLocations(GLuint program);
+	void enableFields(GLuint program);
+	void disableFields();
 	void renderSetup(GLenum mode);
 	void renderFinish();
+	void freeRange(std::map<size_t, size_t>& ranges, size_t start,
+	               size_t count);
+	void uploadRanges(GLenum target, const char* data, size_t size,
+	                  size_t& GPU_size, std::vector<Range>& ranges);
+	static void markDirty(std::vector<Range>& ranges, size_t begin, size_t end);
+	void markVertices(size_t first, size_t last);
+	void markIndices(size_t first, size_t last);
 };
 } //namespace ftgl
@@ -0,0 +1,165 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include "opengl.h"
+#include "vec234.h"
+
+namespace ftgl {
+
+/**
+ * Description of one attribute of a vertex struct, built at compile time.
+ *
+ * A vertex format lists the fields of its vertex struct once, with their
+ * shader names and offsets:
+ * @code
+ * struct GlyphVertex
+ * {
+ *     ftgl::vec3 position;
+ *     ftgl::vec2 tex_coord;
+ *     ftgl::vec4 color;
+ * };
+ *
+ * struct GlyphFormat
+ * {
+ *     using vertex_type = GlyphVertex;
+ *     static constexpr ftgl::VertexField fields[] = {
+ *         ftgl::vertexField<ftgl::vec3>("vertex", offsetof(GlyphVertex, position)),
+ *         ftgl::vertexField<ftgl::vec2>("tex_coord", offsetof(GlyphVertex, tex_coord)),
+ *         ftgl::vertexField<ftgl::vec4>("color", offsetof(GlyphVertex, color)),
+ *     };
+ * };
+ *
+ * ftgl::TypedVertexBuffer<GlyphFormat> buffer;
+ * @endcode
+ */
+struct VertexField
+{
+	/** Name of the attribute in the shader */
+	const char* name;
+
+	/** Number of components, 1 to 4 */
+	int size;
+
+	/** GL type of a component */
+	GLenum type;
+
+	/** Whether integer components are normalized to [0, 1] or [-1, 1] */
+	bool normalized;
+
+	/** Offset of the attribute in the vertex, in bytes */
+	size_t offset;
+
+	/** Size of the attribute in the vertex, in bytes */
+	size_t bytes;
+};
+
+/**
+ * GL type and component count of the C++ type of a vertex field. Scalars,
+ * arrays of scalars and the vec234 types are understood.
+ */
+template <typename T> struct VertexComponents;
+
+template <GLenum Type, int Size>
+struct VertexComponentsOf
+{
+	static constexpr GLenum type = Type;
+	static constexpr int size = Size;
+};
+
+template <> struct VertexComponents<GLbyte> : VertexComponentsOf<GL_BYTE, 1> {};
+template <> struct VertexComponents<GLubyte> : VertexComponentsOf<GL_UNSIGNED_BYTE, 1> {};
+template <> struct VertexComponents<GLshort> : VertexComponentsOf<GL_SHORT, 1> {};
+template <> struct VertexComponents<GLushort> : VertexComponentsOf<GL_UNSIGNED_SHORT, 1> {};
+template <> struct VertexComponents<GLint> : VertexComponentsOf<GL_INT, 1> {};
+template <> struct VertexComponents<GLuint> : VertexComponentsOf<GL_UNSIGNED_INT, 1> {};
+template <> struct VertexComponents<GLfloat> : VertexComponentsOf<GL_FLOAT, 1> {};
+
+template <> struct VertexComponents<vec2> : VertexComponentsOf<GL_FLOAT, 2> {};
+template <> struct VertexComponents<vec3> : VertexComponentsOf<GL_FLOAT, 3> {};
+template <> struct VertexComponents<vec4> : VertexComponentsOf<GL_FLOAT, 4> {};
+template <> struct VertexComponents<ivec2> : VertexComponentsOf<GL_INT, 2> {};
+template <> struct VertexComponents<ivec3> : VertexComponentsOf<GL_INT, 3> {};
+template <> struct VertexComponents<ivec4> : VertexComponentsOf<GL_INT, 4> {};
+
+template <typename T, size_t N>
+struct VertexComponents<T[N]> :
+	VertexComponentsOf<VertexComponents<T>::type, int(N)>
+{
+	static_assert(VertexComponents<T>::size == 1,
+		"Vertex field arrays must hold scalars");
+	static_assert(N >= 1 && N <= 4, "Vertex fields have 1 to 4 components");
+};
+
+/**
+ *  Describe a vertex field of C++ type T.
+ *
+ *  @param name        name of the attribute in the shader
+ *  @param offset      offsetof the field in the vertex struct
+ *  @param normalized  whether integer components are normalized
+ */
+template <typename T>
+constexpr VertexField vertexField(const char* name, size_t offset,
+	bool normalized = false)
+{
+	return { name, VertexComponents<T>::size, VertexComponents<T>::type,
+		normalized, offset, sizeof(T) };
+}
+
+/**
+ *  Whether the fields of a format lie inside its vertex struct without
+ *  overlapping each other.
+ */
+template <typename Format>
+constexpr bool validVertexFormat()
+{
+	constexpr size_t count = sizeof(Format::fields) / sizeof(VertexField);
+	for (size_t i = 0; i < count; ++i)
+	{
+		const VertexField& field = Format::fields[i];
+		if (field.offset + field.bytes > sizeof(typename Format::vertex_type))
+			return false;
+
+		for (size_t j = 0; j < i; ++j)
+		{
+			const VertexField& other = Format::fields[j];
+			if (field.offset < other.offset + other.bytes &&
+				other.offset < field.offset + field.bytes)
+				return false;
+		}
+	}
+	return true;
+}
+
+}//namespace ftgl
@@ -48,6 +48,28 @@ public:
 
 };
 
+// Packs 50k glyph-sized regions into a 4096x4096 atlas
+void benchmarkAtlas()
+{
+	std::mt19937 rng(1);
+	std::uniform_int_distribution<size_t> width(4, 18);
+	std::uniform_int_distribution<size_t> height(6, 22);
+
+	ftgl::TextureAtlas atlas(4096, 4096, 1);
+	size_t placed = 0;
+	{
+		std::cout << "\natlas: 50000 insertions\n";
+		ScopedTimer t;
+		for (size_t i = 0; i < 50'000; ++i)
+		{
+			if (atlas.getRegion(width(rng), height(rng)).x >= 0)
+				++placed;
+		}
+	}
+	std::cout << placed << " placed, " << atlas.nodes().size()
+	          << " skyline nodes" << std::endl;
+}
+
 struct st
 {
 	float x, y, z;
@@ -68,6 +90,8 @@ int main()
 
 	//buffer.render(GL_LINE);
 
+	benchmarkAtlas();
+
 	init();
 	char tmp[] = { '\0', '\0', '\0', '\0', '\0', '\0' };
 	const char* str = tmp;
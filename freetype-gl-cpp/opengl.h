@@ -34,7 +34,11 @@
 #ifndef __OPEN_GL_H__
 #define __OPEN_GL_H__
 
-#if defined(__APPLE__)
+// FREETYPE_GL_GL_HEADER replaces the platform headers, e.g. with a recording
+// GL stand-in to exercise the upload paths without a context.
+#if defined(FREETYPE_GL_GL_HEADER)
+#   include FREETYPE_GL_GL_HEADER
+#elif defined(__APPLE__)
 #   include "TargetConditionals.h"
 #   if TARGET_OS_SIMULATOR || TARGET_OS_IPHONE
 #     if defined(FREETYPE_GL_ES_VERSION_3_0)
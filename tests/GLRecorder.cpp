@@ -0,0 +1,448 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include "GLRecorder.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <map>
+
+namespace {
+
+std::vector<std::string> log_lines;
+std::map<GLuint, std::vector<unsigned char>> buffer_storage;
+std::vector<unsigned char> texture_image;
+std::map<GLenum, GLuint> bindings;
+std::map<GLuint, std::vector<std::string>> attribute_names;
+GLuint next_name = 1;
+size_t next_fence = 1;
+GLuint current_program = 0;
+
+void record(const char* format, ...)
+{
+	char line[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(line, sizeof(line), format, args);
+	va_end(args);
+	log_lines.push_back(line);
+}
+
+const char* target_name(GLenum target)
+{
+	switch (target)
+	{
+	case GL_ARRAY_BUFFER: return "ARRAY";
+	case GL_ELEMENT_ARRAY_BUFFER: return "ELEMENT_ARRAY";
+	case GL_PIXEL_UNPACK_BUFFER: return "PIXEL_UNPACK";
+	case GL_DRAW_INDIRECT_BUFFER: return "DRAW_INDIRECT";
+	default: return "?";
+	}
+}
+
+void gen_names(GLsizei n, GLuint* names)
+{
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		names[i] = next_name++;
+	}
+}
+
+std::vector<unsigned char>& bound_storage(GLenum target)
+{
+	return buffer_storage[bindings[target]];
+}
+
+}
+
+int glrec::wait_timeouts = 0;
+int glrec::map_failures = 0;
+int glrec::unmap_failures = 0;
+
+const std::vector<std::string>& glrec::calls()
+{
+	return log_lines;
+}
+
+int glrec::find(const std::string& prefix, int from)
+{
+	for (size_t i = size_t(std::max(from, 0)); i < log_lines.size(); ++i)
+	{
+		if (log_lines[i].compare(0, prefix.size(), prefix) == 0)
+		{
+			return int(i);
+		}
+	}
+	return -1;
+}
+
+int glrec::count(const std::string& prefix)
+{
+	int n = 0;
+	for (int i = find(prefix); i != -1; i = find(prefix, i + 1))
+	{
+		++n;
+	}
+	return n;
+}
+
+void glrec::dump()
+{
+	for (auto&& line : log_lines)
+	{
+		printf("    %s\n", line.c_str());
+	}
+}
+
+void glrec::reset()
+{
+	log_lines.clear();
+	texture_image.clear();
+	wait_timeouts = 0;
+	map_failures = 0;
+	unmap_failures = 0;
+}
+
+GLuint glrec::binding(GLenum target)
+{
+	return bindings[target];
+}
+
+std::vector<unsigned char>& glrec::storage(GLuint buffer)
+{
+	return buffer_storage[buffer];
+}
+
+const std::vector<unsigned char>& glrec::image()
+{
+	return texture_image;
+}
+
+extern "C" {
+
+void glBindBuffer(GLenum target, GLuint buffer)
+{
+	record("BindBuffer %s %u", target_name(target), buffer);
+	bindings[target] = buffer;
+}
+
+void glBindTexture(GLenum, GLuint texture)
+{
+	record("BindTexture %u", texture);
+}
+
+void glBindVertexArray(GLuint array)
+{
+	record("BindVertexArray %u", array);
+}
+
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum)
+{
+	record("BufferData %s %td", target_name(target), size);
+	auto& storage = bound_storage(target);
+	storage.assign(size_t(size), 0);
+	if (data)
+	{
+		memcpy(storage.data(), data, size_t(size));
+	}
+}
+
+void glBufferStorage(GLenum target, GLsizeiptr size, const void* data,
+	GLbitfield flags)
+{
+	record("BufferStorage %s %td %x", target_name(target), size, flags);
+	auto& storage = bound_storage(target);
+	storage.assign(size_t(size), 0);
+	if (data)
+	{
+		memcpy(storage.data(), data, size_t(size));
+	}
+}
+
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+	const void* data)
+{
+	record("BufferSubData %s %td %td", target_name(target), offset, size);
+	auto& storage = bound_storage(target);
+	if (storage.size() >= size_t(offset + size))
+	{
+		memcpy(storage.data() + offset, data, size_t(size));
+	}
+}
+
+GLenum glClientWaitSync(GLsync sync, GLbitfield, GLuint64)
+{
+	record("ClientWaitSync %zu", size_t(sync));
+	if (glrec::wait_timeouts > 0)
+	{
+		--glrec::wait_timeouts;
+		return GL_TIMEOUT_EXPIRED;
+	}
+	return GL_CONDITION_SATISFIED;
+}
+
+void glCompressedTexImage2D(GLenum, GLint level, GLenum, GLsizei width,
+	GLsizei height, GLint, GLsizei size, const void*)
+{
+	record("CompressedTexImage2D %d %dx%d %d", level, width, height, size);
+}
+
+void glCompressedTexSubImage2D(GLenum, GLint level, GLint x, GLint y,
+	GLsizei width, GLsizei height, GLenum, GLsizei size, const void*)
+{
+	record("CompressedTexSubImage2D %d %d,%d %dx%d %d",
+		level, x, y, width, height, size);
+}
+
+void glDeleteBuffers(GLsizei n, const GLuint* buffers)
+{
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		record("DeleteBuffers %u", buffers[i]);
+		buffer_storage.erase(buffers[i]);
+	}
+}
+
+void glDeleteSync(GLsync sync)
+{
+	record("DeleteSync %zu", size_t(sync));
+}
+
+void glDeleteTextures(GLsizei n, const GLuint* textures)
+{
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		record("DeleteTextures %u", textures[i]);
+	}
+}
+
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays)
+{
+	for (GLsizei i = 0; i < n; ++i)
+	{
+		record("DeleteVertexArrays %u", arrays[i]);
+	}
+}
+
+void glDisableVertexAttribArray(GLuint index)
+{
+	record("DisableVertexAttribArray %u", index);
+}
+
+void glDrawArrays(GLenum mode, GLint first, GLsizei count)
+{
+	record("DrawArrays %x %d %d", mode, first, count);
+}
+
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+	GLsizei instances)
+{
+	record("DrawArraysInstanced %x %d %d %d", mode, first, count, instances);
+}
+
+void glDrawElements(GLenum mode, GLsizei count, GLenum type,
+	const void* indices)
+{
+	record("DrawElements %x %d %x %zu", mode, count, type, size_t(indices));
+}
+
+void glEnableVertexAttribArray(GLuint index)
+{
+	record("EnableVertexAttribArray %u", index);
+}
+
+GLsync glFenceSync(GLenum, GLbitfield)
+{
+	record("FenceSync %zu", next_fence);
+	return reinterpret_cast<GLsync>(next_fence++);
+}
+
+void glGenBuffers(GLsizei n, GLuint* buffers)
+{
+	gen_names(n, buffers);
+	record("GenBuffers %u", buffers[0]);
+}
+
+void glGenTextures(GLsizei n, GLuint* textures)
+{
+	gen_names(n, textures);
+	record("GenTextures %u", textures[0]);
+}
+
+void glGenVertexArrays(GLsizei n, GLuint* arrays)
+{
+	gen_names(n, arrays);
+	record("GenVertexArrays %u", arrays[0]);
+}
+
+GLint glGetAttribLocation(GLuint program, const GLchar* name)
+{
+	// Locations follow the order in which a program is first asked
+	auto& names = attribute_names[program];
+	size_t location = 0;
+	while (location < names.size() && names[location] != name)
+	{
+		++location;
+	}
+	if (location == names.size())
+	{
+		names.push_back(name);
+	}
+	record("GetAttribLocation %u %s %zu", program, name, location);
+	return GLint(location);
+}
+
+void glGetIntegerv(GLenum pname, GLint* data)
+{
+	record("GetIntegerv %x", pname);
+	*data = pname == GL_CURRENT_PROGRAM ? GLint(current_program) : 0;
+}
+
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+	GLbitfield access)
+{
+	record("MapBufferRange %s %td %td %x", target_name(target), offset,
+		length, access);
+	if (glrec::map_failures > 0)
+	{
+		--glrec::map_failures;
+		return nullptr;
+	}
+	auto& storage = bound_storage(target);
+	if (storage.size() < size_t(offset + length))
+	{
+		return nullptr;
+	}
+	return storage.data() + offset;
+}
+
+void glMultiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count,
+	GLsizei drawcount)
+{
+	record("MultiDrawArrays %x %d", mode, drawcount);
+	for (GLsizei i = 0; i < drawcount; ++i)
+	{
+		record("  %d %d", first[i], count[i]);
+	}
+}
+
+void glMultiDrawElements(GLenum mode, const GLsizei* count, GLenum type,
+	const void* const* indices, GLsizei drawcount)
+{
+	record("MultiDrawElements %x %x %d", mode, type, drawcount);
+	for (GLsizei i = 0; i < drawcount; ++i)
+	{
+		record("  %d %zu", count[i], size_t(indices[i]));
+	}
+}
+
+void glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect,
+	GLsizei drawcount, GLsizei stride)
+{
+	record("MultiDrawElementsIndirect %x %x %zu %d %d", mode, type,
+		size_t(indirect), drawcount, stride);
+}
+
+void glPixelStorei(GLenum pname, GLint param)
+{
+	record("PixelStorei %x %d", pname, param);
+}
+
+void glTexImage2D(GLenum, GLint level, GLint, GLsizei width, GLsizei height,
+	GLint, GLenum format, GLenum, const void* data)
+{
+	record("TexImage2D %d %dx%d %x %s", level, width, height, format,
+		data ? "data" : "null");
+
+	if (level == 0 && data)
+	{
+		size_t depth = format == GL_RGBA || format == GL_BGRA ? 4
+			: format == GL_RGB ? 3 : 1;
+		const unsigned char* pixels = static_cast<const unsigned char*>(data);
+		texture_image.assign(pixels, pixels + size_t(width) * height * depth);
+	}
+}
+
+void glTexParameteri(GLenum, GLenum pname, GLint param)
+{
+	record("TexParameteri %x %d", pname, param);
+}
+
+void glTexSubImage2D(GLenum, GLint level, GLint x, GLint y, GLsizei width,
+	GLsizei height, GLenum, GLenum, const void* data)
+{
+	// With a pixel unpack buffer bound the pointer is an offset into it
+	GLuint unpack = bindings[GL_PIXEL_UNPACK_BUFFER];
+	if (unpack)
+	{
+		record("TexSubImage2D %d %d,%d %dx%d buffer %u offset %zu",
+			level, x, y, width, height, unpack, size_t(data));
+	}
+	else
+	{
+		record("TexSubImage2D %d %d,%d %dx%d client",
+			level, x, y, width, height);
+	}
+}
+
+GLboolean glUnmapBuffer(GLenum target)
+{
+	record("UnmapBuffer %s", target_name(target));
+	if (glrec::unmap_failures > 0)
+	{
+		--glrec::unmap_failures;
+		return GL_FALSE;
+	}
+	return GL_TRUE;
+}
+
+void glUseProgram(GLuint program)
+{
+	record("UseProgram %u", program);
+	current_program = program;
+}
+
+void glVertexAttribDivisor(GLuint index, GLuint divisor)
+{
+	record("VertexAttribDivisor %u %u", index, divisor);
+}
+
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type,
+	GLboolean normalized, GLsizei stride, const void* pointer)
+{
+	record("VertexAttribPointer %u %d %x %d %d %zu", index, size, type,
+		normalized, stride, size_t(pointer));
+}
+
+}
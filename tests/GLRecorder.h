@@ -0,0 +1,225 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * Recording GL stand-in for the tests, selected with
+ * FREETYPE_GL_GL_HEADER="GLRecorder.h" in place of the platform headers.
+ *
+ * It declares the subset of GL the library uses; every call is appended
+ * to glrec::calls() as one line ("BindBuffer PIXEL_UNPACK 3") and the
+ * tests check the order of the lines. Buffers get real storage so mapped
+ * writes land somewhere, and a few switches make the driver misbehave.
+ */
+
+typedef unsigned int GLenum;
+typedef unsigned int GLbitfield;
+typedef unsigned int GLuint;
+typedef int GLint;
+typedef int GLsizei;
+typedef unsigned char GLboolean;
+typedef signed char GLbyte;
+typedef short GLshort;
+typedef unsigned char GLubyte;
+typedef unsigned short GLushort;
+typedef float GLfloat;
+typedef char GLchar;
+typedef void GLvoid;
+typedef std::ptrdiff_t GLsizeiptr;
+typedef std::ptrdiff_t GLintptr;
+typedef uint64_t GLuint64;
+typedef struct __GLsync* GLsync;
+
+#define GL_FALSE                          0
+#define GL_TRUE                           1
+#define GL_TRIANGLES                      0x0004
+#define GL_TRIANGLE_STRIP                 0x0005
+#define GL_UNPACK_ROW_LENGTH              0x0CF2
+#define GL_UNPACK_ALIGNMENT               0x0CF5
+#define GL_TEXTURE_2D                     0x0DE1
+#define GL_BYTE                           0x1400
+#define GL_UNSIGNED_BYTE                  0x1401
+#define GL_SHORT                          0x1402
+#define GL_UNSIGNED_SHORT                 0x1403
+#define GL_INT                            0x1404
+#define GL_UNSIGNED_INT                   0x1405
+#define GL_FLOAT                          0x1406
+#define GL_RED                            0x1903
+#define GL_RGB                            0x1907
+#define GL_RGBA                           0x1908
+#define GL_LUMINANCE                      0x1909
+#define GL_LINE                           0x1B01
+#define GL_LINEAR                         0x2601
+#define GL_LINEAR_MIPMAP_LINEAR           0x2703
+#define GL_TEXTURE_MAG_FILTER             0x2800
+#define GL_TEXTURE_MIN_FILTER             0x2801
+#define GL_TEXTURE_WRAP_S                 0x2802
+#define GL_TEXTURE_WRAP_T                 0x2803
+#define GL_BGRA                           0x80E1
+#define GL_CLAMP_TO_EDGE                  0x812F
+#define GL_TEXTURE_MAX_LEVEL              0x813D
+#define GL_UNSIGNED_INT_8_8_8_8_REV       0x8367
+#define GL_ARRAY_BUFFER                   0x8892
+#define GL_ELEMENT_ARRAY_BUFFER           0x8893
+#define GL_STREAM_DRAW                    0x88E0
+#define GL_STATIC_DRAW                    0x88E4
+#define GL_DYNAMIC_DRAW                   0x88E8
+#define GL_PIXEL_UNPACK_BUFFER            0x88EC
+#define GL_BOOL                           0x8B56
+#define GL_CURRENT_PROGRAM                0x8B8D
+#define GL_COMPRESSED_RED_RGTC1           0x8DBB
+#define GL_DRAW_INDIRECT_BUFFER           0x8F3F
+#define GL_SYNC_GPU_COMMANDS_COMPLETE     0x9117
+#define GL_ALREADY_SIGNALED               0x911A
+#define GL_TIMEOUT_EXPIRED                0x911B
+#define GL_CONDITION_SATISFIED            0x911C
+#define GL_WAIT_FAILED                    0x911D
+#define GL_SYNC_FLUSH_COMMANDS_BIT        0x00000001
+#define GL_MAP_WRITE_BIT                  0x0002
+#define GL_MAP_INVALIDATE_RANGE_BIT       0x0004
+#define GL_MAP_UNSYNCHRONIZED_BIT         0x0020
+#define GL_MAP_PERSISTENT_BIT             0x0040
+#define GL_MAP_COHERENT_BIT               0x0080
+
+extern "C" {
+
+void glBindBuffer(GLenum target, GLuint buffer);
+void glBindTexture(GLenum target, GLuint texture);
+void glBindVertexArray(GLuint array);
+void glBufferData(GLenum target, GLsizeiptr size, const void* data, GLenum usage);
+void glBufferStorage(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+void glBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size, const void* data);
+GLenum glClientWaitSync(GLsync sync, GLbitfield flags, GLuint64 timeout);
+void glCompressedTexImage2D(GLenum target, GLint level, GLenum internalformat,
+	GLsizei width, GLsizei height, GLint border, GLsizei size, const void* data);
+void glCompressedTexSubImage2D(GLenum target, GLint level, GLint x, GLint y,
+	GLsizei width, GLsizei height, GLenum format, GLsizei size, const void* data);
+void glDeleteBuffers(GLsizei n, const GLuint* buffers);
+void glDeleteSync(GLsync sync);
+void glDeleteTextures(GLsizei n, const GLuint* textures);
+void glDeleteVertexArrays(GLsizei n, const GLuint* arrays);
+void glDisableVertexAttribArray(GLuint index);
+void glDrawArrays(GLenum mode, GLint first, GLsizei count);
+void glDrawArraysInstanced(GLenum mode, GLint first, GLsizei count, GLsizei instances);
+void glDrawElements(GLenum mode, GLsizei count, GLenum type, const void* indices);
+void glEnableVertexAttribArray(GLuint index);
+GLsync glFenceSync(GLenum condition, GLbitfield flags);
+void glGenBuffers(GLsizei n, GLuint* buffers);
+void glGenTextures(GLsizei n, GLuint* textures);
+void glGenVertexArrays(GLsizei n, GLuint* arrays);
+GLint glGetAttribLocation(GLuint program, const GLchar* name);
+void glGetIntegerv(GLenum pname, GLint* data);
+void* glMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length, GLbitfield access);
+void glMultiDrawArrays(GLenum mode, const GLint* first, const GLsizei* count, GLsizei drawcount);
+void glMultiDrawElements(GLenum mode, const GLsizei* count, GLenum type,
+	const void* const* indices, GLsizei drawcount);
+void glMultiDrawElementsIndirect(GLenum mode, GLenum type, const void* indirect,
+	GLsizei drawcount, GLsizei stride);
+void glPixelStorei(GLenum pname, GLint param);
+void glTexImage2D(GLenum target, GLint level, GLint internalformat, GLsizei width,
+	GLsizei height, GLint border, GLenum format, GLenum type, const void* data);
+void glTexParameteri(GLenum target, GLenum pname, GLint param);
+void glTexSubImage2D(GLenum target, GLint level, GLint x, GLint y, GLsizei width,
+	GLsizei height, GLenum format, GLenum type, const void* data);
+GLboolean glUnmapBuffer(GLenum target);
+void glUseProgram(GLuint program);
+void glVertexAttribDivisor(GLuint index, GLuint divisor);
+void glVertexAttribPointer(GLuint index, GLint size, GLenum type, GLboolean normalized,
+	GLsizei stride, const void* pointer);
+
+}
+
+namespace glrec {
+
+/**
+ * Calls since the last reset(), one line each
+ */
+const std::vector<std::string>& calls();
+
+/**
+ * Index of the first call starting with prefix at or after from, or -1
+ */
+int find(const std::string& prefix, int from = 0);
+
+/**
+ * Number of calls starting with prefix
+ */
+int count(const std::string& prefix);
+
+/**
+ * Print the calls to stdout, for debugging a failing test
+ */
+void dump();
+
+/**
+ * Forget the calls, the image and the switches below; GL objects stay
+ * alive.
+ */
+void reset();
+
+/**
+ * Buffer bound to a target, 0 if none
+ */
+GLuint binding(GLenum target);
+
+/**
+ * Storage of a buffer
+ */
+std::vector<unsigned char>& storage(GLuint buffer);
+
+/**
+ * Pixels of the last base level given to glTexImage2D with data
+ */
+const std::vector<unsigned char>& image();
+
+/**
+ * glClientWaitSync times out this many times before a fence signals
+ */
+extern int wait_timeouts;
+
+/**
+ * glMapBufferRange fails this many times
+ */
+extern int map_failures;
+
+/**
+ * glUnmapBuffer reports a corrupted data store this many times
+ */
+extern int unmap_failures;
+
+}//namespace glrec
@@ -0,0 +1,265 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include "Check.h"
+#include "BC4.h"
+
+namespace {
+
+// Palette of a block as written in the RGTC1 specification, unrounded
+void spec_palette(const unsigned char* block, float* palette)
+{
+	float r0 = block[0];
+	float r1 = block[1];
+
+	palette[0] = r0;
+	palette[1] = r1;
+	if (block[0] > block[1])
+	{
+		for (int i = 2; i < 8; ++i)
+		{
+			palette[i] = ((8 - i) * r0 + (i - 1) * r1) / 7.0f;
+		}
+	}
+	else
+	{
+		for (int i = 2; i < 6; ++i)
+		{
+			palette[i] = ((6 - i) * r0 + (i - 1) * r1) / 5.0f;
+		}
+		palette[6] = 0.0f;
+		palette[7] = 255.0f;
+	}
+}
+
+void spec_decode(const unsigned char* block, float* pixels)
+{
+	float palette[8];
+	spec_palette(block, palette);
+
+	uint64_t bits = 0;
+	for (int i = 0; i < 6; ++i)
+	{
+		bits |= uint64_t(block[2 + i]) << (8 * i);
+	}
+	for (int i = 0; i < 16; ++i)
+	{
+		pixels[i] = palette[(bits >> (3 * i)) & 7];
+	}
+}
+
+/*
+ * Encode a 4x4 block with both encoders and check that they agree, that
+ * every pixel decodes to the palette entry closest to it, and that the
+ * library decoder rounds the specification values to the nearest integer.
+ */
+bool check_block(const unsigned char* pixels)
+{
+	unsigned char block[ftgl::BC4_BLOCK_SIZE];
+	unsigned char scalar[ftgl::BC4_BLOCK_SIZE];
+	ftgl::bc4_encode_block(pixels, 4, block);
+	ftgl::bc4_encode_block_scalar(pixels, 4, scalar);
+	if (memcmp(block, scalar, sizeof(block)) != 0)
+		return false;
+
+	float palette[8];
+	float decoded[16];
+	spec_palette(block, palette);
+	spec_decode(block, decoded);
+
+	unsigned char rounded[16];
+	ftgl::bc4_decode_block(block, rounded, 4);
+
+	for (int i = 0; i < 16; ++i)
+	{
+		float best = 256.0f;
+		for (float value : palette)
+		{
+			best = std::min(best, std::fabs(value - pixels[i]));
+		}
+		if (std::fabs(decoded[i] - pixels[i]) > best + 1e-3f)
+			return false;
+		if (std::fabs(rounded[i] - decoded[i]) > 0.5f)
+			return false;
+	}
+	return true;
+}
+
+}
+
+TEST(bc4_flat_blocks_are_exact)
+{
+	for (int value : { 0, 1, 127, 128, 254, 255 })
+	{
+		unsigned char pixels[16];
+		memset(pixels, value, sizeof(pixels));
+		CHECK(check_block(pixels));
+
+		unsigned char block[ftgl::BC4_BLOCK_SIZE];
+		unsigned char decoded[16];
+		ftgl::bc4_encode_block(pixels, 4, block);
+		ftgl::bc4_decode_block(block, decoded, 4);
+		CHECK(memcmp(decoded, pixels, sizeof(pixels)) == 0);
+	}
+}
+
+TEST(bc4_two_value_blocks_are_exact)
+{
+	const int pairs[][2] = { { 0, 255 }, { 0, 1 }, { 254, 255 }, { 17, 200 } };
+	std::mt19937 random(1);
+
+	for (auto&& pair : pairs)
+	{
+		unsigned char pixels[16];
+		for (auto& pixel : pixels)
+		{
+			pixel = static_cast<unsigned char>(pair[random() & 1]);
+		}
+		pixels[0] = static_cast<unsigned char>(pair[0]);
+		pixels[15] = static_cast<unsigned char>(pair[1]);
+		CHECK(check_block(pixels));
+
+		unsigned char block[ftgl::BC4_BLOCK_SIZE];
+		unsigned char decoded[16];
+		ftgl::bc4_encode_block(pixels, 4, block);
+		ftgl::bc4_decode_block(block, decoded, 4);
+		CHECK(memcmp(decoded, pixels, sizeof(pixels)) == 0);
+	}
+}
+
+TEST(bc4_extremes_and_ramps)
+{
+	unsigned char pixels[16];
+
+	// Every level of the full range, then a ramp exercising the rounding
+	for (int i = 0; i < 16; ++i)
+	{
+		pixels[i] = static_cast<unsigned char>(i * 17);
+	}
+	CHECK(check_block(pixels));
+
+	for (int range = 1; range < 256; ++range)
+	{
+		for (int i = 0; i < 16; ++i)
+		{
+			pixels[i] = static_cast<unsigned char>(i * range / 15);
+		}
+		CHECK(check_block(pixels));
+
+		for (int i = 0; i < 16; ++i)
+		{
+			pixels[i] = static_cast<unsigned char>(255 - pixels[i]);
+		}
+		CHECK(check_block(pixels));
+	}
+}
+
+TEST(bc4_random_blocks)
+{
+	std::mt19937 random(42);
+	unsigned char pixels[16];
+
+	for (int n = 0; n < 100000; ++n)
+	{
+		// Narrow ranges too, glyph edges rarely span the whole range
+		int lo = int(random() % 256);
+		int span = 1 + int(random() % (256 - lo));
+		for (auto& pixel : pixels)
+		{
+			pixel = static_cast<unsigned char>(lo + int(random() % span));
+		}
+		if (!check_block(pixels))
+		{
+			CHECK(check_block(pixels));
+			break;
+		}
+	}
+}
+
+TEST(bc4_decoder_handles_both_modes)
+{
+	std::mt19937 random(7);
+	unsigned char block[ftgl::BC4_BLOCK_SIZE];
+
+	for (int n = 0; n < 100000; ++n)
+	{
+		for (auto& byte : block)
+		{
+			byte = static_cast<unsigned char>(random());
+		}
+
+		float decoded[16];
+		unsigned char rounded[16];
+		spec_decode(block, decoded);
+		ftgl::bc4_decode_block(block, rounded, 4);
+
+		bool close = true;
+		for (int i = 0; i < 16; ++i)
+		{
+			close = close && std::fabs(rounded[i] - decoded[i]) <= 0.5f;
+		}
+		if (!close)
+		{
+			CHECK(close);
+			break;
+		}
+	}
+}
+
+TEST(bc4_encoder_honours_the_stride)
+{
+	unsigned char image[8 * 4];
+	for (int i = 0; i < 32; ++i)
+	{
+		image[i] = static_cast<unsigned char>(i * 8);
+	}
+
+	unsigned char pixels[16];
+	for (int row = 0; row < 4; ++row)
+	{
+		memcpy(pixels + 4 * row, image + 8 * row + 4, 4);
+	}
+
+	unsigned char strided[ftgl::BC4_BLOCK_SIZE];
+	unsigned char packed[ftgl::BC4_BLOCK_SIZE];
+	ftgl::bc4_encode_block(image + 4, 8, strided);
+	ftgl::bc4_encode_block(pixels, 4, packed);
+	CHECK(memcmp(strided, packed, sizeof(packed)) == 0);
+	ftgl::bc4_encode_block_scalar(image + 4, 8, strided);
+	CHECK(memcmp(strided, packed, sizeof(packed)) == 0);
+}
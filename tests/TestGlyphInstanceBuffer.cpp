@@ -0,0 +1,119 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstring>
+#include <string>
+#include "Check.h"
+#include "GlyphInstanceBuffer.h"
+
+namespace {
+
+// Two instances of the same glyph metrics
+void fill(ftgl::GlyphInstanceBuffer& text)
+{
+	ftgl::GlyphMetrics metrics = {};
+	metrics.width = 8;
+	metrics.height = 12;
+	text.add(metrics, 0, 0, 0xffffffff);
+	text.add(metrics, 10, 0, 0xff0000ff);
+}
+
+}
+
+TEST(instances_sample_the_atlas_sampler)
+{
+	std::string vertex = ftgl::GlyphInstanceBuffer::VERTEX_SHADER;
+	std::string fragment = ftgl::GlyphInstanceBuffer::FRAGMENT_SHADER;
+
+	CHECK(fragment.find("uniform sampler2D atlas;") != std::string::npos);
+	CHECK(fragment.find("texture(atlas, v_tex_coord)") != std::string::npos);
+	CHECK(fragment.find("texture2D") == std::string::npos);
+	CHECK(vertex.find("v_layer") == std::string::npos);
+	CHECK(fragment.find("v_layer") == std::string::npos);
+}
+
+TEST(instances_draw_with_one_divisor_per_attribute)
+{
+	glrec::reset();
+	glUseProgram(11);
+	ftgl::GlyphInstanceBuffer text;
+	fill(text);
+	text.render();
+
+	CHECK(glrec::count("GenVertexArrays") == 1);
+	CHECK(glrec::count("GetAttribLocation 11 ") == 5);
+	CHECK(glrec::count("VertexAttribDivisor") == 5);
+	CHECK(glrec::count("VertexAttribPointer 0 2 1406 0 28 0") == 1);
+	CHECK(glrec::count("DrawArraysInstanced 5 0 4 2") == 1);
+	CHECK(glrec::binding(GL_ARRAY_BUFFER) == 0);
+
+	// Drawing again reuses the vertex array as it is
+	glrec::reset();
+	text.render();
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer") == 0);
+	CHECK(glrec::count("DrawArraysInstanced 5 0 4 2") == 1);
+}
+
+TEST(instances_set_the_vertex_array_up_again_for_another_program)
+{
+	glrec::reset();
+	glUseProgram(12);
+	ftgl::GlyphInstanceBuffer text;
+	fill(text);
+	text.render();
+
+	// The second program has color at location 0 and position at 1
+	glGetAttribLocation(13, "color");
+	glUseProgram(13);
+	glrec::reset();
+	text.render();
+
+	CHECK(glrec::count("GenVertexArrays") == 0);
+	CHECK(glrec::count("GetAttribLocation 13 ") == 5);
+	CHECK(glrec::count("VertexAttribPointer 1 2 1406 0 28 0") == 1);
+	CHECK(glrec::count("VertexAttribPointer 0 4 1401 1 28 20") == 1);
+
+	// Locations of the first program are released before the new ones
+	int disable = glrec::find("DisableVertexAttribArray");
+	int enable = glrec::find("EnableVertexAttribArray");
+	CHECK(disable != -1 && disable < enable);
+	CHECK(glrec::find("VertexAttribPointer") < glrec::find("DrawArraysInstanced"));
+
+	// And back to the first one
+	glUseProgram(12);
+	glrec::reset();
+	text.render();
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer 0 2 1406 0 28 0") == 1);
+}
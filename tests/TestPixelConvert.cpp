@@ -0,0 +1,161 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstring>
+#include <random>
+#include <vector>
+#include "Check.h"
+#include "PixelConvert.h"
+#include "TextureAtlas.h"
+
+// The vector loops of PixelConvert.cpp are picked by Simd.h: build the
+// tests with -mssse3, on ARM, and with FTGL_NO_SIMD to cover all of them.
+
+namespace {
+
+// Counts around the vector widths, with scalar tails of every length
+const size_t COUNTS[] = { 0, 1, 3, 4, 5, 7, 15, 16, 17, 31, 32, 33, 47, 48,
+	49, 63, 64, 65, 100 };
+
+std::vector<unsigned char> noise(size_t size)
+{
+	std::mt19937 random(size_t(7) + size);
+	std::vector<unsigned char> data(size);
+	for (auto& value : data)
+	{
+		value = (unsigned char)(random() & 0xff);
+	}
+	return data;
+}
+
+// Convert count pixels of bytes_in with convert, from every misalignment,
+// and compare them with what expect gives per pixel. The byte after the
+// converted pixels must be left alone.
+template<typename Convert, typename Expect>
+bool convertsLike(size_t bytes_in, size_t bytes_out, Convert convert,
+	Expect expect)
+{
+	for (size_t count : COUNTS)
+	{
+		for (size_t offset = 0; offset < 4; ++offset)
+		{
+			std::vector<unsigned char> src = noise(offset + count * bytes_in);
+			std::vector<unsigned char> dst(offset + count * bytes_out + 1, 0xa5);
+			convert(src.data() + offset, dst.data() + offset, count);
+
+			for (size_t i = 0; i < count; ++i)
+			{
+				unsigned char pixel[4];
+				expect(src.data() + offset + i * bytes_in, pixel);
+				if (memcmp(dst.data() + offset + i * bytes_out, pixel,
+					bytes_out) != 0)
+				{
+					return false;
+				}
+			}
+			if (dst.back() != 0xa5)
+				return false;
+		}
+	}
+	return true;
+}
+
+// Reversing table, so that a lut that is skipped shows
+unsigned char LUT[256];
+
+void fillLut()
+{
+	for (int i = 0; i < 256; ++i)
+	{
+		LUT[i] = (unsigned char)(255 - i);
+	}
+}
+
+}
+
+TEST(gray_conversions_match_the_scalar_ones)
+{
+	fillLut();
+	CHECK(convertsLike(1, 1,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_gray_lut(s, d, n, LUT); },
+		[](const unsigned char* s, unsigned char* p) { p[0] = LUT[s[0]]; }));
+	CHECK(convertsLike(1, 3,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_gray_rgb(s, d, n); },
+		[](const unsigned char* s, unsigned char* p) { memset(p, s[0], 3); }));
+	CHECK(convertsLike(1, 3,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_gray_rgb(s, d, n, LUT); },
+		[](const unsigned char* s, unsigned char* p) { memset(p, LUT[s[0]], 3); }));
+	CHECK(convertsLike(1, 4,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_gray_rgba(s, d, n); },
+		[](const unsigned char* s, unsigned char* p) { memset(p, s[0], 4); }));
+	CHECK(convertsLike(1, 4,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_gray_rgba(s, d, n, LUT); },
+		[](const unsigned char* s, unsigned char* p) { memset(p, LUT[s[0]], 4); }));
+}
+
+TEST(swaps_match_the_scalar_ones)
+{
+	CHECK(convertsLike(3, 3,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_swap3(s, d, n); },
+		[](const unsigned char* s, unsigned char* p)
+		{ p[0] = s[2]; p[1] = s[1]; p[2] = s[0]; }));
+	CHECK(convertsLike(4, 4,
+		[](const unsigned char* s, unsigned char* d, size_t n)
+		{ ftgl::convert_swap4(s, d, n); },
+		[](const unsigned char* s, unsigned char* p)
+		{ p[0] = s[2]; p[1] = s[1]; p[2] = s[0]; p[3] = s[3]; }));
+}
+
+TEST(atlas_refuses_formats_it_cannot_store)
+{
+	using Format = ftgl::TextureAtlas::Format;
+	const unsigned char data[4 * 4 * 4] = {};
+	ftgl::TextureAtlas gray(64, 64, 1);
+	CHECK(!gray.setRegion(1, 1, 4, 4, data, 12, Format::RGB));
+	CHECK(!gray.setRegion(1, 1, 4, 4, data, 16, Format::BGRA));
+	CHECK(gray.setRegion(1, 1, 4, 4, data, 4, Format::Gray));
+
+	ftgl::TextureAtlas rgb(64, 64, 3);
+	CHECK(!rgb.setRegion(1, 1, 4, 4, data, 16, Format::RGBA));
+	CHECK(rgb.setRegion(1, 1, 4, 4, data, 12, Format::BGR));
+
+	ftgl::TextureAtlas rgba(64, 64, 4);
+	CHECK(!rgba.setRegion(1, 1, 4, 4, data, 12, Format::RGB));
+	CHECK(rgba.setRegion(1, 1, 4, 4, data, 16, Format::RGBA));
+}
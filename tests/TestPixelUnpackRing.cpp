@@ -0,0 +1,216 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Check.h"
+#include "PixelUnpackRing.h"
+#include "TextureAtlas.h"
+
+namespace {
+
+// Stage size bytes through the ring and update a texture from them
+bool stream(ftgl::PixelUnpackRing& ring, size_t size)
+{
+	unsigned char* staging = ring.map(size);
+	if (!staging)
+		return false;
+
+	memset(staging, 0x80, size);
+	if (!ring.unmap())
+		return false;
+
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, GLsizei(size), 1,
+		GL_RED, GL_UNSIGNED_BYTE, nullptr);
+	ring.fence();
+	return true;
+}
+
+// Trailing number of the call at index, e.g. the fence of "FenceSync 3"
+size_t argument(int index)
+{
+	const std::string& call = glrec::calls()[index];
+	return size_t(strtoul(call.c_str() + call.rfind(' ') + 1, nullptr, 10));
+}
+
+}
+
+TEST(ring_fences_each_upload_and_waits_before_reuse)
+{
+	glrec::reset();
+	ftgl::PixelUnpackRing ring(2);
+
+	CHECK(stream(ring, 64));
+	CHECK(stream(ring, 64));
+	CHECK(glrec::binding(GL_PIXEL_UNPACK_BUFFER) == 0);
+	CHECK(glrec::count("ClientWaitSync") == 0);
+
+	int first_fence = glrec::find("FenceSync");
+	int second_fence = glrec::find("FenceSync", first_fence + 1);
+	CHECK(first_fence != -1 && second_fence != -1);
+
+	// Map, unmap, update from the buffer, fence, unbind
+	int map = glrec::find("MapBufferRange PIXEL_UNPACK");
+	int unmap = glrec::find("UnmapBuffer PIXEL_UNPACK", map);
+	int update = glrec::find("TexSubImage2D", unmap);
+	CHECK(map != -1 && map < unmap && unmap < update && update < first_fence);
+	CHECK(glrec::calls()[update].find("buffer") != std::string::npos);
+	CHECK(glrec::find("BindBuffer PIXEL_UNPACK 0", first_fence) == first_fence + 1);
+
+	// The third upload goes back to the first buffer, once its fence signaled
+	int third = int(glrec::calls().size());
+	CHECK(stream(ring, 64));
+	int wait = glrec::find("ClientWaitSync", third);
+	CHECK(wait != -1 && wait < glrec::find("MapBufferRange", third));
+	CHECK(argument(wait) == argument(first_fence));
+	CHECK(glrec::find("DeleteSync", wait) == wait + 1);
+}
+
+TEST(ring_keeps_waiting_while_the_fence_times_out)
+{
+	glrec::reset();
+	ftgl::PixelUnpackRing ring(1);
+
+	CHECK(stream(ring, 16));
+	glrec::wait_timeouts = 2;
+	int second = int(glrec::calls().size());
+	CHECK(stream(ring, 16));
+
+	CHECK(glrec::count("ClientWaitSync") == 3);
+	int last_wait = glrec::find("ClientWaitSync", glrec::find("ClientWaitSync", second) + 2);
+	CHECK(last_wait < glrec::find("MapBufferRange", second));
+}
+
+TEST(ring_grows_buffers_geometrically)
+{
+	glrec::reset();
+	ftgl::PixelUnpackRing ring(1);
+
+	CHECK(stream(ring, 100));
+	CHECK(stream(ring, 150));
+	CHECK(stream(ring, 180));
+	CHECK(glrec::count("BufferData") == 2);
+	CHECK(glrec::find("BufferData PIXEL_UNPACK 200") != -1);
+}
+
+TEST(ring_unmap_failure_unbinds_without_fence)
+{
+	glrec::reset();
+	ftgl::PixelUnpackRing ring(1);
+
+	glrec::unmap_failures = 1;
+	CHECK(!stream(ring, 32));
+	CHECK(glrec::binding(GL_PIXEL_UNPACK_BUFFER) == 0);
+	CHECK(glrec::count("FenceSync") == 0);
+
+	// Nothing was issued from the buffer, it is reused right away
+	CHECK(stream(ring, 32));
+	CHECK(glrec::count("ClientWaitSync") == 0);
+	CHECK(glrec::count("GenBuffers") == 1);
+}
+
+TEST(ring_map_failure_leaves_nothing_bound)
+{
+	glrec::reset();
+	ftgl::PixelUnpackRing ring(2);
+
+	glrec::map_failures = 1;
+	CHECK(ring.map(32) == nullptr);
+	CHECK(glrec::binding(GL_PIXEL_UNPACK_BUFFER) == 0);
+}
+
+TEST(atlas_streams_dirty_regions_from_the_ring)
+{
+	unsigned char pixels[16] = { 0 };
+	ftgl::TextureAtlas atlas(64, 64, 1);
+	atlas.setStreaming(2);
+	atlas.upload();
+
+	glrec::reset();
+	atlas.setRegion(1, 1, 4, 4, pixels, 4);
+	atlas.upload();
+
+	int update = glrec::find("TexSubImage2D");
+	CHECK(update > glrec::find("UnmapBuffer"));
+	CHECK(glrec::calls()[update].find("buffer") != std::string::npos);
+	CHECK(glrec::find("FenceSync", update) != -1);
+	CHECK(glrec::binding(GL_PIXEL_UNPACK_BUFFER) == 0);
+}
+
+TEST(atlas_uploads_directly_when_the_staging_buffer_is_lost)
+{
+	unsigned char pixels[16] = { 0 };
+	ftgl::TextureAtlas atlas(64, 64, 1);
+	atlas.setStreaming(2);
+	atlas.upload();
+
+	glrec::reset();
+	glrec::unmap_failures = 1;
+	atlas.setRegion(1, 1, 4, 4, pixels, 4);
+	atlas.upload();
+
+	// The corrupted buffer is dropped and the region sent from client memory
+	int unmap = glrec::find("UnmapBuffer");
+	int update = glrec::find("TexSubImage2D");
+	CHECK(unmap != -1 && update > unmap);
+	CHECK(glrec::calls()[update].find("client") != std::string::npos);
+	CHECK(glrec::count("TexSubImage2D") == 1);
+	CHECK(glrec::count("FenceSync") == 0);
+
+	// The next upload streams again
+	glrec::reset();
+	atlas.setRegion(8, 8, 4, 4, pixels, 4);
+	atlas.upload();
+	update = glrec::find("TexSubImage2D");
+	CHECK(update != -1);
+	CHECK(glrec::calls()[update].find("buffer") != std::string::npos);
+}
+
+TEST(atlas_uploads_directly_when_the_staging_buffer_cannot_be_mapped)
+{
+	unsigned char pixels[16] = { 0 };
+	ftgl::TextureAtlas atlas(64, 64, 1);
+	atlas.setStreaming(2);
+	atlas.upload();
+
+	glrec::reset();
+	glrec::map_failures = 1;
+	atlas.setRegion(1, 1, 4, 4, pixels, 4);
+	atlas.upload();
+
+	int update = glrec::find("TexSubImage2D");
+	CHECK(update != -1);
+	CHECK(glrec::calls()[update].find("client") != std::string::npos);
+	CHECK(glrec::count("UnmapBuffer") == 0);
+}
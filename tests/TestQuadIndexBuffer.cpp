@@ -0,0 +1,130 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Check.h"
+#include "QuadIndexBuffer.h"
+
+namespace {
+
+// Index i of the shared buffer, of the current index type; -1 past its
+// end
+GLuint quadIndex(GLuint id, size_t i)
+{
+	size_t offset = i * ftgl::QuadIndexBuffer::elementSize();
+	if (offset + ftgl::QuadIndexBuffer::elementSize() > glrec::storage(id).size())
+		return GLuint(-1);
+
+	const unsigned char* data = glrec::storage(id).data() + offset;
+	if (ftgl::QuadIndexBuffer::type() == GL_UNSIGNED_SHORT)
+	{
+		GLushort index;
+		memcpy(&index, data, sizeof(index));
+		return index;
+	}
+	GLuint index;
+	memcpy(&index, data, sizeof(index));
+	return index;
+}
+
+// Whether quad holds the corners 0 1 2 0 2 3 of its 4 vertices
+bool holdsQuad(GLuint id, size_t quad)
+{
+	static const GLuint QUAD[6] = { 0, 1, 2, 0, 2, 3 };
+	for (size_t i = 0; i < 6; ++i)
+	{
+		if (quadIndex(id, quad * 6 + i) != GLuint(quad * 4) + QUAD[i])
+			return false;
+	}
+	return true;
+}
+
+}
+
+TEST(quad_indices_grow_by_half_at_least)
+{
+	ftgl::QuadIndexBuffer::abandon();
+	glrec::reset();
+
+	// 256 quads at least, 16-bit indices
+	GLuint id = ftgl::QuadIndexBuffer::reserve(10);
+	CHECK(glrec::count("GenBuffers") == 1);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY 3072") == 1);
+	CHECK(ftgl::QuadIndexBuffer::type() == GL_UNSIGNED_SHORT);
+	CHECK(holdsQuad(id, 0) && holdsQuad(id, 255));
+	CHECK(glrec::binding(GL_ELEMENT_ARRAY_BUFFER) == 0);
+
+	CHECK(ftgl::QuadIndexBuffer::reserve(256) == id);
+	CHECK(glrec::count("BufferData") == 1);
+
+	// One quad more grows the buffer by half
+	CHECK(ftgl::QuadIndexBuffer::reserve(257) == id);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY 4608") == 1);
+	CHECK(holdsQuad(id, 383));
+	CHECK(ftgl::QuadIndexBuffer::reserve(384) == id);
+	CHECK(glrec::count("BufferData") == 2);
+	CHECK(glrec::count("GenBuffers") == 1);
+}
+
+TEST(quad_indices_widen_past_short_quads)
+{
+	ftgl::QuadIndexBuffer::abandon();
+	glrec::reset();
+
+	GLuint id = ftgl::QuadIndexBuffer::reserve(12000);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY 144000") == 1);
+
+	// Growing by half stops where 16-bit indices end
+	ftgl::QuadIndexBuffer::reserve(12001);
+	size_t short_quads = ftgl::QuadIndexBuffer::SHORT_QUADS;
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY " +
+		std::to_string(short_quads * 6 * sizeof(GLushort))) == 1);
+	CHECK(ftgl::QuadIndexBuffer::type() == GL_UNSIGNED_SHORT);
+	CHECK(holdsQuad(id, short_quads - 1));
+	CHECK(quadIndex(id, short_quads * 6 - 1) == 65535);
+
+	// Past it, indices are 32-bit and growth resumes
+	ftgl::QuadIndexBuffer::reserve(short_quads + 1);
+	size_t quads = short_quads + short_quads / 2;
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY " +
+		std::to_string(quads * 6 * sizeof(GLuint))) == 1);
+	CHECK(ftgl::QuadIndexBuffer::type() == GL_UNSIGNED_INT);
+	CHECK(ftgl::QuadIndexBuffer::elementSize() == sizeof(GLuint));
+	CHECK(holdsQuad(id, short_quads) && holdsQuad(id, quads - 1));
+	CHECK(quadIndex(id, short_quads * 6) == 65536);
+
+	ftgl::QuadIndexBuffer::abandon();
+	CHECK(ftgl::QuadIndexBuffer::type() == GL_UNSIGNED_SHORT);
+}
@@ -0,0 +1,246 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Check.h"
+#include "StreamingVertexBuffer.h"
+
+namespace {
+
+// Two floats per vertex: 8 bytes, partitions of 64 bytes for 4 vertices
+// and 6 indices
+const char* const FORMAT = "vertex:2f";
+const size_t PARTITION_SIZE = 64;
+
+// Write a quad and draw the frame
+bool frame(ftgl::StreamingVertexBuffer& buffer)
+{
+	if (!buffer.begin())
+		return false;
+
+	auto span = buffer.allocate(4, 6);
+	if (!span.vertices)
+		return false;
+
+	memset(span.vertices, 0, 4 * 2 * sizeof(float));
+	const GLuint quad[] = { 0, 1, 2, 0, 2, 3 };
+	for (size_t i = 0; i < 6; ++i)
+	{
+		span.indices[i] = quad[i] + span.base;
+	}
+	buffer.render(GL_TRIANGLES);
+	return true;
+}
+
+// Trailing number of the call at index, e.g. the fence of "FenceSync 3"
+size_t argument(int index)
+{
+	const std::string& call = glrec::calls()[index];
+	return size_t(strtoul(call.c_str() + call.rfind(' ') + 1, nullptr, 10));
+}
+
+}
+
+TEST(streaming_persistent_maps_once_and_fences_after_each_draw)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6);
+
+	CHECK(frame(buffer));
+	CHECK(frame(buffer));
+	CHECK(frame(buffer));
+	CHECK(buffer.persistent());
+	CHECK(glrec::count("BufferStorage ARRAY 192") == 1);
+	CHECK(glrec::count("MapBufferRange") == 1);
+	CHECK(glrec::count("UnmapBuffer") == 0);
+	CHECK(glrec::count("ClientWaitSync") == 0);
+
+	// Each frame's fence follows its draw, and comes before the next draw
+	int draw = -1;
+	for (int i = 0; i < 3; ++i)
+	{
+		draw = glrec::find("DrawElements", draw + 1);
+		int fence = glrec::find("FenceSync", draw);
+		CHECK(draw != -1 && fence != -1);
+		int next = glrec::find("DrawElements", draw + 1);
+		CHECK(next == -1 || fence < next);
+	}
+}
+
+TEST(streaming_persistent_waits_for_the_partition_before_reuse)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6);
+
+	CHECK(frame(buffer));
+	size_t first_fence = argument(glrec::find("FenceSync"));
+	CHECK(frame(buffer));
+	CHECK(frame(buffer));
+	int last_draw = glrec::find("DrawElements", glrec::find("FenceSync",
+		glrec::find("FenceSync") + 1) + 1);
+
+	// Back to the first partition: its fence is waited on and deleted
+	// before anything is written or drawn
+	CHECK(buffer.begin());
+	int wait = glrec::find("ClientWaitSync", last_draw);
+	CHECK(wait != -1 && argument(wait) == first_fence);
+	int release = glrec::find("DeleteSync", wait);
+	CHECK(release != -1 && argument(release) == first_fence);
+	CHECK(glrec::find("DrawElements", last_draw + 1) == -1);
+	CHECK(buffer.stats().waits == 0);
+
+	auto span = buffer.allocate(4, 6);
+	CHECK(span.vertices != nullptr);
+	CHECK(span.base == 0);
+}
+
+TEST(streaming_persistent_counts_blocking_waits)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6);
+
+	for (size_t i = 0; i < ftgl::StreamingVertexBuffer::PARTITIONS; ++i)
+	{
+		CHECK(frame(buffer));
+	}
+
+	// The poll and one blocking wait time out, the next one is satisfied
+	glrec::wait_timeouts = 2;
+	int from = int(glrec::calls().size());
+	CHECK(buffer.begin());
+	CHECK(glrec::find("ClientWaitSync", from) != -1);
+	CHECK(glrec::count("ClientWaitSync") == 3);
+	CHECK(buffer.stats().waits == 1);
+}
+
+TEST(streaming_spans_index_the_vertices_of_their_partition)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6);
+
+	CHECK(frame(buffer));
+	CHECK(buffer.begin());
+	auto span = buffer.allocate(2, 3);
+	CHECK(span.base == PARTITION_SIZE / 8);
+	span.indices[0] = 42;
+	auto more = buffer.allocate(2, 3);
+	CHECK(more.base == span.base + 2);
+	CHECK(more.indices == span.indices + 3);
+	CHECK(buffer.allocate(1, 0).vertices == nullptr);
+	CHECK(buffer.stats().overflows == 1);
+
+	// Indices of the second partition sit after its 4 vertices
+	GLuint id = GLuint(argument(glrec::find("GenBuffers")));
+	GLuint index;
+	memcpy(&index, glrec::storage(id).data() + PARTITION_SIZE + 32,
+		sizeof(index));
+	CHECK(index == 42);
+
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("DrawElements 4 6 1405 96") == 1);
+}
+
+TEST(streaming_unsynchronized_maps_each_partition_and_orphans_on_wrap)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6, false);
+
+	for (size_t i = 0; i <= ftgl::StreamingVertexBuffer::PARTITIONS; ++i)
+	{
+		CHECK(frame(buffer));
+	}
+	CHECK(!buffer.persistent());
+	CHECK(glrec::count("FenceSync") == 0);
+	CHECK(glrec::count("BufferData ARRAY 192") == 2);
+	CHECK(glrec::count("MapBufferRange ARRAY 0 64") == 2);
+	CHECK(glrec::count("MapBufferRange ARRAY 64 64") == 1);
+	CHECK(glrec::count("MapBufferRange ARRAY 128 64") == 1);
+
+	// Each partition is unmapped before it is drawn from
+	int draw = -1;
+	for (int map = glrec::find("MapBufferRange"); map != -1;
+		map = glrec::find("MapBufferRange", map + 1))
+	{
+		int unmap = glrec::find("UnmapBuffer", map);
+		draw = glrec::find("DrawElements", map);
+		CHECK(unmap != -1 && unmap < draw);
+	}
+}
+
+TEST(streaming_unsynchronized_begin_twice_unmaps_first)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6, false);
+
+	CHECK(buffer.begin());
+	CHECK(buffer.allocate(4, 6).vertices != nullptr);
+	CHECK(buffer.begin());
+
+	int first = glrec::find("MapBufferRange");
+	int second = glrec::find("MapBufferRange", first + 1);
+	int unmap = glrec::find("UnmapBuffer", first);
+	CHECK(second != -1);
+	CHECK(unmap != -1 && unmap < second);
+
+	// The dropped frame's room is available again, in the same partition
+	CHECK(glrec::count("MapBufferRange ARRAY 0 64") == 2);
+	auto span = buffer.allocate(4, 6);
+	CHECK(span.vertices != nullptr);
+	CHECK(span.base == 0);
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("UnmapBuffer") == 2);
+}
+
+TEST(streaming_falls_back_when_persistent_mapping_fails)
+{
+	glrec::reset();
+	glUseProgram(1);
+	glrec::map_failures = 1;
+	ftgl::StreamingVertexBuffer buffer(FORMAT, 4, 6);
+
+	CHECK(frame(buffer));
+	CHECK(!buffer.persistent());
+	CHECK(glrec::count("BufferStorage") == 1);
+	CHECK(glrec::count("DeleteBuffers") == 1);
+	CHECK(glrec::count("BufferData ARRAY 192") == 1);
+	CHECK(glrec::count("FenceSync") == 0);
+	CHECK(glrec::count("DrawElements") == 1);
+}
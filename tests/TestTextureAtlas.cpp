@@ -0,0 +1,142 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstring>
+#include <vector>
+#include "Check.h"
+#include "TextureAtlas.h"
+#include "opengl.h"
+
+namespace {
+
+// Gray pixels numbered from value, row after row
+std::vector<unsigned char> pixels(size_t width, size_t height,
+	unsigned char value)
+{
+	std::vector<unsigned char> data(width * height);
+	for (size_t i = 0; i < data.size(); ++i)
+	{
+		data[i] = (unsigned char)(value + i);
+	}
+	return data;
+}
+
+}
+
+TEST(atlas_matches_regions_across_tiles)
+{
+	using Format = ftgl::TextureAtlas::Format;
+	for (size_t depth : { 1, 3, 4 })
+	{
+		ftgl::TextureAtlas atlas(256, 256, depth);
+
+		// Straddles the tiles at 64, 64
+		std::vector<unsigned char> data = pixels(20, 10, 1);
+		atlas.setRegion(50, 60, 20, 10, data.data(), 20, Format::Gray);
+		CHECK(atlas.matchRegion(50, 60, 20, 10, data.data(), 20, Format::Gray));
+
+		// One pixel off in the second tile
+		data[9 * 20 + 19] ^= 1;
+		CHECK(!atlas.matchRegion(50, 60, 20, 10, data.data(), 20, Format::Gray));
+
+		// Elsewhere, or of another size
+		data[9 * 20 + 19] ^= 1;
+		CHECK(!atlas.matchRegion(51, 60, 20, 10, data.data(), 20, Format::Gray));
+		CHECK(!atlas.matchRegion(50, 60, 20, 10, data.data() + 1, 20,
+			Format::Gray));
+	}
+}
+
+TEST(atlas_matches_nothing_once_gpu_resident_data_is_uploaded)
+{
+	using Format = ftgl::TextureAtlas::Format;
+	ftgl::TextureAtlas atlas(64, 64, 1);
+	atlas.setGpuResident(true);
+
+	std::vector<unsigned char> data = pixels(8, 8, 1);
+	atlas.setRegion(4, 4, 8, 8, data.data(), 8, Format::Gray);
+	CHECK(atlas.matchRegion(4, 4, 8, 8, data.data(), 8, Format::Gray));
+
+	atlas.upload();
+	CHECK(!atlas.matchRegion(4, 4, 8, 8, data.data(), 8, Format::Gray));
+}
+
+TEST(concurrent_atlas_takes_empty_regions_on_band_boundaries)
+{
+	ftgl::TextureAtlas atlas(256, 256, 1);
+	atlas.setConcurrent(4);
+
+	// Bands are 64 rows high. A space glyph has no rows, and its region
+	// may start on the first row of a band
+	std::vector<unsigned char> data = pixels(5, 4, 1);
+	atlas.setRegion(10, 64, 5, 0, data.data(), 5);
+	atlas.setRegion(10, 128, 0, 4, data.data(), 5);
+	atlas.setRegion(10, 60, 5, 4, data.data(), 5);
+	CHECK(atlas.matchRegion(10, 60, 5, 4, data.data(), 5,
+		ftgl::TextureAtlas::Format::Gray));
+
+	glrec::reset();
+	atlas.upload();
+	CHECK(glrec::count("TexSubImage2D") + glrec::count("TexImage2D") > 0);
+}
+
+TEST(new_atlas_texture_is_sent_in_one_call)
+{
+	using Format = ftgl::TextureAtlas::Format;
+	for (size_t bands : { 0, 4 })
+	{
+		// Regions in three tiles
+		ftgl::TextureAtlas atlas(256, 256, 1);
+		atlas.setConcurrent(bands);
+		std::vector<unsigned char> data = pixels(20, 10, 1);
+		atlas.setRegion(50, 20, 20, 10, data.data(), 20, Format::Gray);
+		atlas.setRegion(200, 130, 20, 10, data.data(), 20, Format::Gray);
+
+		glrec::reset();
+		atlas.upload();
+		CHECK(glrec::count("TexImage2D 0 256x256 1903 data") == 1);
+		CHECK(glrec::count("TexSubImage2D") == 0);
+
+		std::vector<unsigned char> texture(256 * 256);
+		atlas.readRegion(0, 0, 256, 256, texture.data(), 256);
+		CHECK(glrec::image() == texture);
+		CHECK(texture[25 * 256 + 60] == data[5 * 20 + 10]);
+
+		// Later changes are sent as regions
+		atlas.setRegion(10, 10, 20, 10, data.data(), 20, Format::Gray);
+		glrec::reset();
+		atlas.upload();
+		CHECK(glrec::count("TexImage2D") == 0);
+		CHECK(glrec::count("TexSubImage2D") > 0);
+	}
+}
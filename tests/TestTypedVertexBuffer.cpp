@@ -0,0 +1,153 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include "Check.h"
+#include "TypedVertexBuffer.h"
+
+namespace {
+
+// The format of the VertexFormat.h example
+struct GlyphVertex
+{
+	ftgl::vec3 position;
+	ftgl::vec2 tex_coord;
+	ftgl::vec4 color;
+};
+
+struct GlyphFormat
+{
+	using vertex_type = GlyphVertex;
+	static constexpr ftgl::VertexField fields[] = {
+		ftgl::vertexField<ftgl::vec3>("vertex", offsetof(GlyphVertex, position)),
+		ftgl::vertexField<ftgl::vec2>("tex_coord", offsetof(GlyphVertex, tex_coord)),
+		ftgl::vertexField<ftgl::vec4>("color", offsetof(GlyphVertex, color)),
+	};
+};
+
+using GlyphBuffer = ftgl::TypedVertexBuffer<GlyphFormat>;
+
+static_assert(GlyphBuffer::stride == sizeof(GlyphVertex), "stride");
+static_assert(GlyphBuffer::field_count == 3, "field count");
+static_assert(GlyphBuffer::offset(1) == 12 && GlyphBuffer::offset(2) == 20,
+	"offsets");
+
+GlyphVertex vertex(float x, float y)
+{
+	GlyphVertex v = {};
+	v.position = ftgl::vec3{ { x, y, 0 } };
+	v.tex_coord = ftgl::vec2{ { x, y } };
+	v.color = ftgl::vec4{ { 1, 1, 1, 1 } };
+	return v;
+}
+
+const GLuint QUAD[6] = { 0, 1, 2, 0, 2, 3 };
+
+// Trailing number of the call at index, e.g. the buffer of "GenBuffers 3"
+size_t argument(int index)
+{
+	const std::string& call = glrec::calls()[index];
+	return size_t(strtoul(call.c_str() + call.rfind(' ') + 1, nullptr, 10));
+}
+
+}
+
+TEST(typed_buffer_sets_pointers_from_the_field_table)
+{
+	glrec::reset();
+	glUseProgram(51);
+	GlyphBuffer buffer;
+	const GlyphVertex quad[4] = { vertex(0, 0), vertex(1, 0), vertex(1, 1),
+		vertex(0, 1) };
+	CHECK(buffer.push_back(quad, QUAD) == 0);
+	buffer.render(GL_TRIANGLES);
+
+	CHECK(glrec::count("GetAttribLocation 51 ") == 3);
+	CHECK(glrec::count("VertexAttribPointer 0 3 1406 0 36 0") == 1);
+	CHECK(glrec::count("VertexAttribPointer 1 2 1406 0 36 12") == 1);
+	CHECK(glrec::count("VertexAttribPointer 2 4 1406 0 36 20") == 1);
+	CHECK(glrec::count("DrawElements 4 6 1403 0") == 1);
+
+	// The vertices are sent as the structs are laid out
+	GLuint vertices = GLuint(argument(glrec::find("GenBuffers")));
+	CHECK(glrec::storage(vertices).size() == sizeof(quad));
+	CHECK(memcmp(glrec::storage(vertices).data(), quad, sizeof(quad)) == 0);
+
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer") == 0);
+}
+
+TEST(typed_buffer_follows_program_changes)
+{
+	glrec::reset();
+	GlyphBuffer buffer;
+	const GlyphVertex quad[4] = { vertex(0, 0), vertex(1, 0), vertex(1, 1),
+		vertex(0, 1) };
+	buffer.add(quad, 4, QUAD, 6);
+	buffer.setProgram(53);
+	buffer.render(GL_TRIANGLES);
+
+	// Program 54 puts color first
+	glGetAttribLocation(54, "color");
+	buffer.setProgram(54);
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetIntegerv") == 0);
+	CHECK(glrec::count("GetAttribLocation 54 ") == 3);
+	CHECK(glrec::count("DisableVertexAttribArray") == 3);
+	CHECK(glrec::find("DisableVertexAttribArray 2") <
+		glrec::find("EnableVertexAttribArray"));
+	CHECK(glrec::count("VertexAttribPointer 0 4 1406 0 36 20") == 1);
+	CHECK(glrec::count("VertexAttribPointer 1 3 1406 0 36 0") == 1);
+
+	// Back to the first program: its locations are still known
+	buffer.setProgram(53);
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer 0 3 1406 0 36 0") == 1);
+
+	// Unless it was deleted
+	buffer.forgetProgram(53);
+	buffer.setProgram(54);
+	buffer.render(GL_TRIANGLES);
+	buffer.setProgram(53);
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetAttribLocation 53 ") == 3);
+}
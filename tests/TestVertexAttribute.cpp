@@ -0,0 +1,92 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <vector>
+#include "Check.h"
+#include "VertexAttribute.h"
+
+TEST(vertex_attribute_parses_explicit_locations)
+{
+	glrec::reset();
+	std::vector<ftgl::VertexAttribute> attributes;
+	size_t stride = ftgl::VertexAttribute::parseFormat(
+		"vertex:3f@0,color:4Bn@2,tex_coord:2f", 16, attributes);
+
+	CHECK(stride == 24);
+	CHECK(attributes.size() == 3);
+	CHECK(attributes[0].hasBinding() && attributes[1].hasBinding());
+	CHECK(!attributes[2].hasBinding());
+	CHECK(attributes[1].getType() == GL_UNSIGNED_BYTE);
+	CHECK(attributes[1].isNormalized());
+	CHECK(attributes[1].getPointer() == reinterpret_cast<void*>(12));
+
+	// Given locations need neither a program nor a query
+	CHECK(attributes[0].location(0) == 0);
+	CHECK(attributes[1].location(7) == 2);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+
+	// Others are looked up by name, in a program
+	CHECK(attributes[2].location(0) == -1);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(attributes[2].location(7) == 0);
+	CHECK(glrec::count("GetAttribLocation 7 tex_coord") == 1);
+
+	attributes[1].enable(7);
+	CHECK(glrec::count("EnableVertexAttribArray 2") == 1);
+	CHECK(glrec::count("VertexAttribPointer 2 4 1401 1 24 12") == 1);
+}
+
+TEST(vertex_attribute_caches_locations_per_program)
+{
+	glrec::reset();
+	std::vector<ftgl::VertexAttribute> attributes;
+	ftgl::VertexAttribute::parseFormat("position:2f", 16, attributes);
+	ftgl::VertexAttribute& position = attributes[0];
+
+	// Program 32 has another attribute at location 0
+	glGetAttribLocation(32, "other");
+
+	CHECK(position.location(31) == 0);
+	CHECK(position.location(31) == 0);
+	CHECK(glrec::count("GetAttribLocation 31 position") == 1);
+	CHECK(position.location(32) == 1);
+	CHECK(position.location(31) == 0 && position.location(32) == 1);
+	CHECK(glrec::count("GetAttribLocation 32 position") == 1);
+
+	// A forgotten program is asked again, the others stay cached
+	position.forgetProgram(31);
+	CHECK(position.location(31) == 0);
+	CHECK(position.location(32) == 1);
+	CHECK(glrec::count("GetAttribLocation 31 position") == 2);
+	CHECK(glrec::count("GetAttribLocation 32 position") == 1);
+}
@@ -0,0 +1,650 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "Check.h"
+#include "IndexArray.h"
+#include "QuadIndexBuffer.h"
+#include "VertexBuffer.h"
+
+namespace {
+
+// Two floats per vertex: x is the value of the item, y the vertex number
+const char* const FORMAT = "vertex:2f";
+const size_t STRIDE = 2 * sizeof(float);
+
+const GLuint QUAD[6] = { 0, 1, 2, 0, 2, 3 };
+
+std::vector<float> vertices(size_t count, float value)
+{
+	std::vector<float> data;
+	for (size_t i = 0; i < count; ++i)
+	{
+		data.push_back(value);
+		data.push_back(float(i));
+	}
+	return data;
+}
+
+// Add a quad of 4 vertices and 6 indices whose vertices hold value
+size_t addQuad(ftgl::VertexBuffer& buffer, float value)
+{
+	auto data = vertices(4, value);
+	return buffer.add(reinterpret_cast<const char*>(data.data()), 4, QUAD, 6);
+}
+
+// Trailing number of the call at index, e.g. the buffer of "GenBuffers 3"
+size_t argument(int index)
+{
+	const std::string& call = glrec::calls()[index];
+	return size_t(strtoul(call.c_str() + call.rfind(' ') + 1, nullptr, 10));
+}
+
+// GL buffers of the vertices and indices, generated by the first upload
+// since the last reset
+struct Buffers
+{
+	GLuint vertices;
+	GLuint indices;
+
+	Buffers()
+	{
+		int first = glrec::find("GenBuffers");
+		vertices = GLuint(argument(first));
+		indices = GLuint(argument(glrec::find("GenBuffers", first + 1)));
+	}
+
+	float value(size_t vertex) const
+	{
+		float x;
+		memcpy(&x, glrec::storage(vertices).data() + vertex * STRIDE,
+			sizeof(x));
+		return x;
+	}
+
+	GLuint index(size_t i, size_t size = sizeof(GLushort)) const
+	{
+		const unsigned char* data = glrec::storage(indices).data() + i * size;
+		if (size == sizeof(GLushort))
+		{
+			GLushort index;
+			memcpy(&index, data, sizeof(index));
+			return index;
+		}
+		GLuint index;
+		memcpy(&index, data, sizeof(index));
+		return index;
+	}
+};
+
+}
+
+TEST(vertex_buffer_add_reuses_the_holes_left_by_remove)
+{
+	glrec::reset();
+	ftgl::VertexBuffer buffer(FORMAT);
+	CHECK(addQuad(buffer, 1) == 0);
+	CHECK(addQuad(buffer, 2) == 1);
+	CHECK(addQuad(buffer, 3) == 2);
+	buffer.upload();
+	Buffers ids;
+
+	buffer.remove(1);
+	CHECK(buffer.size() == 3);
+	CHECK(buffer.freeVertices() == 4);
+
+	// The removed item draws nothing until its room is taken again
+	buffer.upload();
+	for (size_t i = 6; i < 12; ++i)
+	{
+		CHECK(ids.index(i) == 0);
+	}
+
+	glrec::reset();
+	CHECK(addQuad(buffer, 4) == 1);
+	CHECK(buffer.freeVertices() == 0);
+	buffer.upload();
+
+	// Only the slot of the new item is sent
+	CHECK(glrec::count("BufferData") == 0);
+	CHECK(glrec::count("BufferSubData ARRAY 32 32") == 1);
+	CHECK(glrec::count("BufferSubData ELEMENT_ARRAY 12 12") == 1);
+	CHECK(ids.value(4) == 4 && ids.value(7) == 4);
+	CHECK(ids.value(8) == 3);
+	CHECK(ids.index(6) == 4 && ids.index(8) == 6 && ids.index(11) == 7);
+}
+
+TEST(vertex_buffer_remove_at_the_end_trims_the_arrays)
+{
+	glrec::reset();
+	ftgl::VertexBuffer buffer(FORMAT);
+	addQuad(buffer, 1);
+	addQuad(buffer, 2);
+	addQuad(buffer, 3);
+
+	// A hole before the last item is merged into the trimmed end
+	buffer.remove(1);
+	CHECK(buffer.freeVertices() == 4);
+	buffer.remove(2);
+	CHECK(buffer.freeVertices() == 0);
+
+	// So the next item follows the first one
+	CHECK(addQuad(buffer, 4) == 2);
+	buffer.upload();
+	Buffers ids;
+	CHECK(glrec::count("BufferData ARRAY 64") == 1);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY 24") == 1);
+	CHECK(ids.value(4) == 4);
+	CHECK(ids.index(6) == 4);
+
+	buffer.remove(0);
+	buffer.remove(2);
+	CHECK(buffer.freeVertices() == 0);
+	CHECK(buffer.size() == 3);
+}
+
+TEST(vertex_buffer_compact_rebases_the_indices)
+{
+	glrec::reset();
+	ftgl::VertexBuffer buffer(FORMAT);
+	addQuad(buffer, 1);
+	addQuad(buffer, 2);
+	addQuad(buffer, 3);
+	buffer.remove(0);
+
+	buffer.compact();
+	CHECK(buffer.freeVertices() == 0);
+	CHECK(buffer.size() == 3);
+	buffer.upload();
+	Buffers ids;
+	CHECK(ids.value(0) == 2 && ids.value(4) == 3);
+	for (size_t i = 0; i < 6; ++i)
+	{
+		CHECK(ids.index(i) == QUAD[i]);
+		CHECK(ids.index(6 + i) == QUAD[i] + 4);
+	}
+
+	// Handles still name the same items
+	auto data = vertices(4, 5);
+	buffer.updateVertices(2, reinterpret_cast<const char*>(data.data()));
+	buffer.upload();
+	CHECK(ids.value(4) == 5 && ids.value(0) == 2);
+
+	// And the removed slot is the next one given out
+	CHECK(addQuad(buffer, 6) == 0);
+	buffer.upload();
+	CHECK(ids.value(8) == 6);
+	CHECK(ids.index(12) == 8);
+}
+
+namespace {
+
+// A buffer of count quads, uploaded once
+void fillQuads(ftgl::VertexBuffer& buffer, size_t count)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		addQuad(buffer, float(i));
+	}
+	buffer.upload();
+}
+
+void updateQuad(ftgl::VertexBuffer& buffer, size_t handle, float value)
+{
+	auto data = vertices(4, value);
+	buffer.updateVertices(handle, reinterpret_cast<const char*>(data.data()));
+}
+
+}
+
+TEST(vertex_buffer_uploads_close_dirty_ranges_as_one)
+{
+	glrec::reset();
+	ftgl::VertexBuffer buffer(FORMAT);
+	fillQuads(buffer, 100);
+	auto before = buffer.uploadStats();
+	CHECK(before.uploads == 1);
+	CHECK(before.full_uploads == 2);
+	CHECK(before.bytes_uploaded == 100 * 4 * STRIDE + 100 * 6 * 2);
+
+	// Quads 0 and 2 are 32 bytes apart, quad 50 is 1504 bytes further
+	glrec::reset();
+	updateQuad(buffer, 0, -1);
+	updateQuad(buffer, 2, -1);
+	updateQuad(buffer, 50, -1);
+	buffer.upload();
+
+	CHECK(glrec::count("BufferData") == 0);
+	CHECK(glrec::count("BufferSubData") == 2);
+	CHECK(glrec::count("BufferSubData ARRAY 0 96") == 1);
+	CHECK(glrec::count("BufferSubData ARRAY 1600 32") == 1);
+
+	auto after = buffer.uploadStats();
+	CHECK(after.uploads == 2);
+	CHECK(after.ranges == before.ranges + 2);
+	CHECK(after.full_uploads == 2);
+	CHECK(after.bytes_uploaded == before.bytes_uploaded + 128);
+	CHECK(after.bytes_saved ==
+		before.bytes_saved + 100 * 4 * STRIDE + 100 * 6 * 2 - 128);
+}
+
+TEST(vertex_buffer_merges_ranges_past_the_limit)
+{
+	glrec::reset();
+	ftgl::VertexBuffer buffer(FORMAT);
+	buffer.setOrphanThreshold(1.0f);
+	fillQuads(buffer, 330);
+
+	// 33 quads 288 bytes apart: too far to merge, one more than the
+	// ranges kept
+	glrec::reset();
+	for (size_t i = 0; i < 33; ++i)
+	{
+		updateQuad(buffer, i * 10, -1);
+	}
+	buffer.upload();
+	CHECK(glrec::count("BufferSubData") == 1);
+	CHECK(glrec::count("BufferSubData ARRAY 0 10272") == 1);
+
+	// 32 such ranges are sent one by one
+	glrec::reset();
+	for (size_t i = 0; i < 32; ++i)
+	{
+		updateQuad(buffer, i * 10, -2);
+	}
+	buffer.upload();
+	CHECK(glrec::count("BufferSubData ARRAY") == 32);
+}
+
+TEST(vertex_buffer_orphans_mostly_modified_arrays)
+{
+	glrec::reset();
+	ftgl::VertexBuffer buffer(FORMAT);
+	fillQuads(buffer, 100);
+	auto before = buffer.uploadStats();
+
+	// 60% of the vertices, above the default threshold of one half
+	glrec::reset();
+	for (size_t i = 0; i < 60; ++i)
+	{
+		updateQuad(buffer, i, -1);
+	}
+	buffer.upload();
+	int orphan = glrec::find("BufferData ARRAY 3200");
+	CHECK(orphan != -1);
+	CHECK(glrec::find("BufferSubData ARRAY 0 3200", orphan) == orphan + 1);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY") == 0);
+	CHECK(glrec::count("BufferSubData ELEMENT_ARRAY") == 0);
+	CHECK(buffer.uploadStats().full_uploads == before.full_uploads + 1);
+
+	// Under a higher threshold the same change goes as a range
+	buffer.setOrphanThreshold(0.7f);
+	glrec::reset();
+	for (size_t i = 0; i < 60; ++i)
+	{
+		updateQuad(buffer, i, -2);
+	}
+	buffer.upload();
+	CHECK(glrec::count("BufferData") == 0);
+	CHECK(glrec::count("BufferSubData ARRAY 0 1920") == 1);
+
+	// A buffer that grows is reallocated by half at least
+	glrec::reset();
+	addQuad(buffer, 100);
+	buffer.upload();
+	CHECK(glrec::count("BufferData ARRAY 4800") == 1);
+	CHECK(glrec::count("BufferSubData ARRAY 0 3232") == 1);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY 1800") == 1);
+}
+
+namespace {
+
+// Calls from index on, as one string, e.g. to compare a multi-draw and
+// its ranges
+std::string callsFrom(int index)
+{
+	std::string text;
+	for (size_t i = size_t(std::max(index, 0)); i < glrec::calls().size(); ++i)
+	{
+		text += glrec::calls()[i] + "\n";
+	}
+	return text;
+}
+
+}
+
+TEST(vertex_buffer_render_items_merges_contiguous_handles)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::VertexBuffer buffer(FORMAT);
+	fillQuads(buffer, 4);
+
+	int from = int(glrec::calls().size());
+	buffer.renderItems(GL_TRIANGLES, { 0, 1, 2 });
+	int draw = glrec::find("MultiDrawElements", from);
+	CHECK(callsFrom(draw).find("MultiDrawElements 4 1403 1\n  18 0\n") == 0);
+
+	// Ranges follow the order of the handles
+	from = int(glrec::calls().size());
+	buffer.renderItems(GL_TRIANGLES, { 2, 3, 0 });
+	draw = glrec::find("MultiDrawElements", from);
+	CHECK(callsFrom(draw).find(
+		"MultiDrawElements 4 1403 2\n  12 24\n  6 0\n") == 0);
+}
+
+TEST(vertex_buffer_render_items_skips_removed_handles)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::VertexBuffer buffer(FORMAT);
+	fillQuads(buffer, 3);
+	buffer.remove(1);
+
+	int from = int(glrec::calls().size());
+	buffer.renderItems(GL_TRIANGLES, { 0, 1, 2 });
+	int draw = glrec::find("MultiDrawElements", from);
+	CHECK(callsFrom(draw).find(
+		"MultiDrawElements 4 1403 2\n  6 0\n  6 24\n") == 0);
+
+	// Nothing left to draw: not even the setup is done
+	buffer.remove(0);
+	buffer.remove(2);
+	from = int(glrec::calls().size());
+	buffer.renderItems(GL_TRIANGLES, { 0, 1, 2 });
+	CHECK(int(glrec::calls().size()) == from);
+}
+
+TEST(vertex_buffer_render_items_without_indices_draws_arrays)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::VertexBuffer buffer(FORMAT);
+	for (size_t i = 0; i < 3; ++i)
+	{
+		auto data = vertices(4, float(i));
+		buffer.add(reinterpret_cast<const char*>(data.data()), 4, QUAD, 0);
+	}
+
+	buffer.renderItems(GL_TRIANGLE_STRIP, { 0, 1 });
+	int draw = glrec::find("MultiDrawArrays");
+	CHECK(callsFrom(draw).find("MultiDrawArrays 5 1\n  0 8\n") == 0);
+
+	int from = int(glrec::calls().size());
+	buffer.renderItems(GL_TRIANGLE_STRIP, { 0, 2 });
+	draw = glrec::find("MultiDrawArrays", from);
+	CHECK(callsFrom(draw).find("MultiDrawArrays 5 2\n  0 4\n  8 4\n") == 0);
+	CHECK(glrec::count("MultiDrawElements") == 0);
+}
+
+TEST(vertex_buffer_render_items_reuses_the_indirect_buffer)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::VertexBuffer buffer(FORMAT);
+	buffer.setIndirectDraws(true);
+	fillQuads(buffer, 4);
+
+	glrec::reset();
+	buffer.renderItems(GL_TRIANGLES, { 0, 2, 3 });
+	GLuint indirect = GLuint(argument(glrec::find("GenBuffers")));
+	CHECK(glrec::count("GenBuffers") == 1);
+	CHECK(glrec::count("BufferData DRAW_INDIRECT 40") == 1);
+	CHECK(glrec::count("MultiDrawElementsIndirect 4 1403 0 2 0") == 1);
+	CHECK(glrec::count("MultiDrawElements ") == 0);
+	CHECK(glrec::binding(GL_DRAW_INDIRECT_BUFFER) == 0);
+
+	// count, instance count, first index, base vertex, base instance
+	const GLuint expected[10] = { 6, 1, 0, 0, 0, 12, 1, 12, 0, 0 };
+	CHECK(glrec::storage(indirect).size() == sizeof(expected));
+	CHECK(memcmp(glrec::storage(indirect).data(), expected,
+		sizeof(expected)) == 0);
+
+	// The same ranges are not sent again
+	glrec::reset();
+	buffer.renderItems(GL_TRIANGLES, { 0, 2, 3 });
+	CHECK(glrec::count("GenBuffers") == 0);
+	CHECK(glrec::count("BufferData DRAW_INDIRECT") == 0);
+	CHECK(glrec::count("BufferSubData DRAW_INDIRECT") == 0);
+	CHECK(glrec::count("MultiDrawElementsIndirect 4 1403 0 2 0") == 1);
+
+	// Fewer or as many ranges fit in the buffer already allocated
+	glrec::reset();
+	buffer.renderItems(GL_TRIANGLES, { 0, 1, 2, 3 });
+	CHECK(glrec::count("BufferData DRAW_INDIRECT") == 0);
+	CHECK(glrec::count("BufferSubData DRAW_INDIRECT 0 20") == 1);
+	CHECK(glrec::count("MultiDrawElementsIndirect 4 1403 0 1 0") == 1);
+
+	glrec::reset();
+	buffer.renderItems(GL_TRIANGLES, { 3, 0 });
+	CHECK(glrec::count("BufferData DRAW_INDIRECT") == 0);
+	CHECK(glrec::count("BufferSubData DRAW_INDIRECT 0 40") == 1);
+	CHECK(glrec::count("MultiDrawElementsIndirect 4 1403 0 2 0") == 1);
+}
+
+TEST(index_array_promotes_past_65535)
+{
+	ftgl::IndexArray indices;
+	indices.push_back(65535);
+	CHECK(indices.type() == GL_UNSIGNED_SHORT);
+	CHECK(indices.elementSize() == sizeof(GLushort));
+
+	indices.push_back(65536);
+	CHECK(indices.type() == GL_UNSIGNED_INT);
+	CHECK(indices.elementSize() == sizeof(GLuint));
+	CHECK(indices.size() == 2);
+	CHECK(indices[0] == 65535 && indices[1] == 65536);
+
+	indices.clear();
+	CHECK(indices.type() == GL_UNSIGNED_SHORT);
+	CHECK(indices.empty());
+}
+
+TEST(vertex_buffer_sends_all_indices_again_when_they_widen)
+{
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::VertexBuffer buffer(FORMAT);
+	buffer.setOrphanThreshold(1.0f);
+
+	// 24 16-bit indices, then 6 once the last quad is removed: the index
+	// buffer keeps room for 48 bytes
+	addQuad(buffer, 1);
+	auto data = vertices(4, 2);
+	const GLuint three_quads[18] = { 0, 1, 2, 0, 2, 3, 0, 1, 2, 0, 2, 3,
+		0, 1, 2, 0, 2, 3 };
+	size_t last = buffer.add(reinterpret_cast<const char*>(data.data()), 4,
+		three_quads, 18);
+	buffer.render(GL_TRIANGLES);
+	Buffers ids;
+	CHECK(glrec::count("DrawElements 4 24 1403 0") == 1);
+	buffer.remove(last);
+
+	// Vertices 4 to 65539: their indices no longer fit on 16 bits
+	auto wide = vertices(65536, 3);
+	const GLuint far[6] = { 0, 1, 2, 65533, 65534, 65535 };
+	buffer.add(reinterpret_cast<const char*>(wide.data()), 65536, far, 6);
+
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+
+	// Same size as the buffer holds, but every index moved
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY") == 0);
+	CHECK(glrec::count("BufferSubData ELEMENT_ARRAY 0 48") == 1);
+	const GLuint expected[12] = { 0, 1, 2, 0, 2, 3, 4, 5, 6, 65537, 65538,
+		65539 };
+	for (size_t i = 0; i < 12; ++i)
+	{
+		CHECK(ids.index(i, sizeof(GLuint)) == expected[i]);
+	}
+	CHECK(glrec::count("DrawElements 4 12 1405 0") == 1);
+
+	// Items are drawn with the wide type too
+	buffer.renderItem(0);
+	CHECK(glrec::count("DrawElements 4 6 1405 0") == 1);
+}
+
+TEST(vertex_buffer_quad_list_remove_and_compact)
+{
+	ftgl::QuadIndexBuffer::abandon();
+	glrec::reset();
+	glUseProgram(1);
+	ftgl::VertexBuffer buffer(FORMAT);
+	buffer.setQuadList(true);
+
+	auto a = vertices(4, 1);
+	auto b = vertices(8, 2);
+	auto c = vertices(4, 3);
+	CHECK(buffer.addQuads(reinterpret_cast<const char*>(a.data()), 4) == 0);
+	CHECK(buffer.addQuads(reinterpret_cast<const char*>(b.data()), 8) == 1);
+	CHECK(buffer.addQuads(reinterpret_cast<const char*>(c.data()), 4) == 2);
+
+	// The removed quads collapse, the shared indices stay
+	buffer.remove(1);
+	CHECK(buffer.freeVertices() == 8);
+	buffer.render(GL_TRIANGLES);
+	Buffers ids;
+	GLuint quads = ftgl::QuadIndexBuffer::reserve(1);
+	CHECK(glrec::find("BindBuffer ELEMENT_ARRAY " + std::to_string(quads),
+		glrec::find("GenVertexArrays")) != -1);
+	CHECK(glrec::count("BufferData ELEMENT_ARRAY 0") == 0);
+	CHECK(glrec::count("DrawElements 4 24 1403 0") == 1);
+	CHECK(ids.value(0) == 1 && ids.value(12) == 3);
+	for (size_t i = 4; i < 12; ++i)
+	{
+		CHECK(ids.value(i) == 0);
+	}
+
+	// A new quad takes the first 4 free vertices
+	auto d = vertices(4, 4);
+	CHECK(buffer.addQuads(reinterpret_cast<const char*>(d.data()), 4) == 1);
+	CHECK(buffer.freeVertices() == 4);
+
+	buffer.compact();
+	CHECK(buffer.freeVertices() == 0);
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("DrawElements 4 18 1403 0") == 1);
+	CHECK(ids.value(0) == 1 && ids.value(4) == 4 && ids.value(8) == 3);
+
+	// Items are drawn from the shared indices at 6 per quad
+	buffer.renderItems(GL_TRIANGLES, { 2 });
+	int draw = glrec::find("MultiDrawElements");
+	CHECK(callsFrom(draw).find("MultiDrawElements 4 1403 1\n  6 24\n") == 0);
+}
+
+TEST(vertex_buffer_queries_the_program_in_use_once)
+{
+	glrec::reset();
+	glUseProgram(41);
+	ftgl::VertexBuffer buffer(FORMAT);
+	addQuad(buffer, 1);
+	buffer.render(GL_TRIANGLES);
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetIntegerv 8b8d") == 1);
+	CHECK(glrec::count("GetAttribLocation 41 vertex") == 1);
+	CHECK(glrec::count("VertexAttribPointer") == 1);
+
+	// Another program in use is not noticed...
+	glUseProgram(42);
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetIntegerv") == 0);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer") == 0);
+
+	// ...unless it is named, which sets the VAO up again without a query
+	glGetAttribLocation(42, "other");
+	buffer.setProgram(42);
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetIntegerv") == 0);
+	CHECK(glrec::count("GetAttribLocation 42 vertex") == 1);
+	int disable = glrec::find("DisableVertexAttribArray 0");
+	int enable = glrec::find("EnableVertexAttribArray 1");
+	CHECK(disable != -1 && disable < enable);
+	CHECK(glrec::count("VertexAttribPointer 1 2 1406 0 8 0") == 1);
+
+	glrec::reset();
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer") == 0);
+}
+
+TEST(vertex_buffer_with_given_locations_makes_no_query)
+{
+	glrec::reset();
+	glUseProgram(0);
+	ftgl::VertexBuffer buffer("vertex:2f@3");
+	addQuad(buffer, 1);
+	buffer.render(GL_TRIANGLES);
+	buffer.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetIntegerv") == 0);
+	CHECK(glrec::count("GetAttribLocation") == 0);
+	CHECK(glrec::count("VertexAttribPointer 3 2 1406 0 8 0") == 1);
+	CHECK(glrec::count("DrawElements 4 6 1403 0") == 2);
+}
+
+TEST(vertex_buffer_forgets_deleted_programs)
+{
+	glrec::reset();
+	ftgl::VertexBuffer named(FORMAT);
+	addQuad(named, 1);
+	named.setProgram(43);
+	named.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetAttribLocation 43 vertex") == 1);
+
+	// Program 43 is deleted and its id given to a new program
+	named.forgetProgram(43);
+	glrec::reset();
+	named.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetAttribLocation 43 vertex") == 1);
+	CHECK(glrec::count("VertexAttribPointer") == 1);
+
+	// Without a named program, the one in use is asked for again
+	glUseProgram(44);
+	ftgl::VertexBuffer found(FORMAT);
+	addQuad(found, 1);
+	found.render(GL_TRIANGLES);
+	found.forgetProgram(44);
+	glUseProgram(45);
+	glrec::reset();
+	found.render(GL_TRIANGLES);
+	CHECK(glrec::count("GetIntegerv 8b8d") == 1);
+	CHECK(glrec::count("GetAttribLocation 45 vertex") == 1);
+	CHECK(glrec::count("VertexAttribPointer") == 1);
+}
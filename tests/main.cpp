@@ -0,0 +1,77 @@
+/* ============================================================================
+ * Freetype GL - A C OpenGL Freetype engine
+ * Platform:    Any
+ * WWW:         https://github.com/rougier/freetype-gl
+ * ----------------------------------------------------------------------------
+ * Copyright 2011,2012 Nicolas P. Rougier. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *
+ *  1. Redistributions of source code must retain the above copyright notice,
+ *     this list of conditions and the following disclaimer.
+ *
+ *  2. Redistributions in binary form must reproduce the above copyright
+ *     notice, this list of conditions and the following disclaimer in the
+ *     documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NICOLAS P. ROUGIER ''AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO
+ * EVENT SHALL NICOLAS P. ROUGIER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT,
+ * INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES
+ * (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES;
+ * LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND
+ * ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * The views and conclusions contained in the software and documentation are
+ * those of the authors and should not be interpreted as representing official
+ * policies, either expressed or implied, of Nicolas P. Rougier.
+ * ============================================================================
+ */
+#include <cstdio>
+#include "Check.h"
+
+namespace {
+
+int failures = 0;
+
+}
+
+ftgl::test::Case::Case(const char* name, void (*run)()) :
+	name(name),
+	run(run)
+{
+	cases().push_back(this);
+}
+
+std::vector<ftgl::test::Case*>& ftgl::test::cases()
+{
+	static std::vector<Case*> registered;
+	return registered;
+}
+
+void ftgl::test::fail(const char* expression, const char* file, int line)
+{
+	fprintf(stderr, "%s:%d: CHECK(%s) failed\n", file, line, expression);
+	++failures;
+}
+
+int main()
+{
+	int failed_cases = 0;
+	for (auto* test : ftgl::test::cases())
+	{
+		int before = failures;
+		test->run();
+		bool passed = failures == before;
+		printf("%-48s %s\n", test->name, passed ? "ok" : "FAILED");
+		failed_cases += passed ? 0 : 1;
+	}
+
+	printf("%d of %zu test cases failed\n", failed_cases,
+		ftgl::test::cases().size());
+	return failed_cases ? 1 : 0;
+}